@@ -6,6 +6,14 @@
 #include <set>
 #include <bitset>
 #include <iterator>
+#include <map>
+#include <sstream>
+#include "factor_graph.h"
+#include "qpbo.h"
+#include "graphcut.h"
+#include "trws.h"
+#include "parity.h"
+#include "mipstart.h"
 
 // use ILOG's STL namespace
 ILOSTLBEGIN
@@ -37,6 +45,30 @@ unsigned long seed;
 bool          use_given_seed = false;
 IloInt        timelimit      = -1;
 bool          use_tb2        = false;
+bool          merge_factors  = true;
+bool          normalize_objective = true;
+double        quantize_scale = -1;
+bool          onehot_encoding = false;
+bool          use_qpbo       = true;
+bool          use_graphcut   = true;
+bool          use_trws       = false;
+bool          use_mipstart   = true;
+bool          split_components = false;
+char          componentPrefix[1024];
+char          mipstartFile[1024];
+char          solutionFile[1024];
+bool          use_cutoff     = false;
+double        upper_cutoff;
+bool          use_stop_above = false;
+double        stop_above;
+bool          use_stop_below = false;
+double        stop_below;
+const char   *stop_reason    = NULL;
+FILE         *progress_out   = NULL;
+int           verbosity      = 1;
+std::ostream *result_out     = NULL;			// the real stdout when verbosity is 0
+struct timeval start_time;
+double        exact_states   = 1 << 20;
 char          instanceName[1024];
 
 //parity matrix
@@ -46,6 +78,16 @@ std::string matrixStr;
 bool externalParity = false;
 bool elim = true;
 
+//sparse parity matrix read from a file, and explicit offsets b
+char matrixFile[1024] = "";
+std::string pegSpec;				// degree distribution of an in-memory PEG code
+std::string pegCache;				// PEG code cache directory, see libpeg.h
+unsigned long peg_seed = 987654321u;		// MainPEG's default, so codes are shared across runs
+int peg_nested = 0;				// checks of the code whose nested family -peg draws from
+bool shuffle_columns = false;
+SparseMatrix sparseMatrix;
+std::string offsetStr;
+
 unsigned long get_seed(void) {
   struct timeval tv;
   struct timezone tzp;
@@ -55,48 +97,13 @@ unsigned long get_seed(void) {
 
 ////////////////////////////////
 
-vector <vector <bool> > parseMatrix(int m, int n)
-{
-  vector <vector <bool> > A;
-  if(matrixStr.empty())
-    return A;
-
-  int len = matrixStr.length();
-
-  const char* matrixChars = matrixStr.c_str();
-
-  A.resize(m);
-  for (int i =0;i<m;i++)
-  {
-    A[i].resize(n+1);
-    A[i][n] = rand()%2==0;     
-  }
-  int rowCounter=0;
-  int colCounter=0;	
-  for (int i=0;i<len;i++){
-    switch(matrixChars[i]){
-      case '1':
-        A[rowCounter][colCounter++] = true;
-        break;
-      case '0':
-        A[rowCounter][colCounter++] = false;
-        break;
-      case '_':
-        colCounter=0;
-        rowCounter++;
-        break;
-    }      
-  }
-  return A;
-}
-
 void parseParityArgs(int & argc, char **argv)
 {
   // this method eats up all arguments that are relevant for the
   // parity constraint, and returns the rest in argc, argv
 
-  char residualArgv[argc][64];
-  strcpy(residualArgv[0], argv[0]);
+  char *residualArgv[argc];
+  residualArgv[0] = argv[0];
   int residualArgc = 1;
 
   for (int argIndex=1; argIndex < argc; ++argIndex) {
@@ -110,6 +117,33 @@ void parseParityArgs(int & argc, char **argv)
       //cout<<"here"<<endl;
       //cout<<strcpy(instanceName, argv[argIndex])<<endl;
     }
+    else if ( !strcmp(argv[argIndex], "-matrix-file") ) {
+      argIndex++;
+      strcpy(matrixFile, argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-peg") ) {
+      argIndex++;
+      pegSpec = string(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-peg-cache") ) {
+      argIndex++;
+      pegCache = string(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-peg-nested") ) {
+      argIndex++;
+      peg_nested = atoi(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-peg-seed") ) {
+      argIndex++;
+      peg_seed = strtoul(argv[argIndex], NULL, 10);
+    }
+    else if ( !strcmp(argv[argIndex], "-matrix-shuffle") ) {
+      shuffle_columns = true;
+    }
+    else if ( !strcmp(argv[argIndex], "-offset") ) {
+      argIndex++;
+      offsetStr = string(argv[argIndex]);
+    }
     else if ( !strcmp(argv[argIndex], "-paritylevel") ) {
       argIndex++;
       parity_filterLevel = atol( argv[argIndex] );
@@ -157,16 +191,13 @@ void parseParityArgs(int & argc, char **argv)
     }
     else {
       // save this option to be returned back
-      strcpy(residualArgv[residualArgc++], argv[argIndex]);
+      residualArgv[residualArgc++] = argv[argIndex];
     }
   }
 
   argc = residualArgc;
-  for (int i=1; i<argc; ++i) {
-    // free(argv[i]);
-    argv[i] = new char[strlen(residualArgv[i])+1];
-    strcpy(argv[i], residualArgv[i]);
-  }
+  for (int i=1; i<argc; ++i)
+    argv[i] = residualArgv[i];
 }
 
 void printParityUsage(ostream & os = cout) {
@@ -177,7 +208,14 @@ void printParityUsage(ostream & os = cout) {
      << "   -paritythreshold    >= 2, for individual Xors (default: 3)" << endl 
      << "   -number             Number of random XORs (default: 0)" << endl
      << "   -minlength          Minlength of XORs (default: nvars/2)" << endl
-     << "   -maxlength          Maxlength of XORs (default: nvars/20)" << endl;
+     << "   -maxlength          Maxlength of XORs (default: nvars/20)" << endl
+     << "   -matrix-file        Sparse parity matrix in alist or compressed rows, - for stdin" << endl
+     << "   -peg                PEG code of -number checks: a MainPEG degree file, or d1:f1,d2:f2,..." << endl
+     << "   -peg-cache          Directory of cached PEG codes to look -peg codes up in or add them to" << endl
+     << "   -peg-nested         Take -peg codes from the nested family of the code of this many checks" << endl
+     << "   -peg-seed           Seed of the -peg code (default: MainPEG's)" << endl
+     << "   -matrix-shuffle     Randomly permute the columns of the -matrix-file or -peg matrix" << endl
+     << "   -offset             Parity b as a string of 0/1, one per row (default: random)" << endl;
   if (!PARITY_DONT_HANDLE_RANDOM_SEED)
     os << "   -seed               Random seed" << endl;
   else {
@@ -205,6 +243,91 @@ void parseArgs(int argc, char **argv)
       argIndex++;
       timelimit = atol(argv[argIndex]);
     }
+    else if ( !strcmp(argv[argIndex], "-nocanon") ) {
+      merge_factors = false;
+    }
+    else if ( !strcmp(argv[argIndex], "-encoding") ) {
+      argIndex++;
+      if ( !strcmp(argv[argIndex], "onehot") )
+        onehot_encoding = true;
+      else if ( !strcmp(argv[argIndex], "binary") )
+        onehot_encoding = false;
+      else {
+        cerr << "ERROR: encoding must be binary or onehot." << endl;
+        exit(1);
+      }
+    }
+    else if ( !strcmp(argv[argIndex], "-trws") ) {
+      use_trws = true;
+    }
+    else if ( !strcmp(argv[argIndex], "-randomstart") ) {
+      use_mipstart = false;
+    }
+    else if ( !strcmp(argv[argIndex], "-mipstart") ) {
+      argIndex++;
+      strcpy(mipstartFile, argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-upper-cutoff") ) {
+      argIndex++;
+      upper_cutoff = atof(argv[argIndex]);
+      use_cutoff = true;
+    }
+    else if ( !strcmp(argv[argIndex], "-stop-above") ) {
+      argIndex++;
+      stop_above = atof(argv[argIndex]);
+      use_stop_above = true;
+    }
+    else if ( !strcmp(argv[argIndex], "-stop-below-bound") ) {
+      argIndex++;
+      stop_below = atof(argv[argIndex]);
+      use_stop_below = true;
+    }
+    else if ( !strcmp(argv[argIndex], "-progress-file") ) {
+      argIndex++;
+      progress_out = fopen(argv[argIndex], "w");
+      if (!progress_out) {
+        cerr << "ERROR: cannot write progress to " << argv[argIndex] << endl;
+        exit(1);
+      }
+    }
+    else if ( !strcmp(argv[argIndex], "-progress-fd") ) {
+      argIndex++;
+      progress_out = fdopen(atoi(argv[argIndex]), "w");
+      if (!progress_out) {
+        cerr << "ERROR: cannot write progress to descriptor " << argv[argIndex] << endl;
+        exit(1);
+      }
+    }
+    else if ( !strcmp(argv[argIndex], "-save-solution") ) {
+      argIndex++;
+      strcpy(solutionFile, argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-nographcut") ) {
+      use_graphcut = false;
+    }
+    else if ( !strcmp(argv[argIndex], "-noqpbo") ) {
+      use_qpbo = false;
+    }
+    else if ( !strcmp(argv[argIndex], "-components") ) {
+      argIndex++;
+      split_components = true;
+      strcpy(componentPrefix, argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-exactstates") ) {
+      argIndex++;
+      exact_states = atof(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-nonormalize") ) {
+      normalize_objective = false;
+    }
+    else if ( !strcmp(argv[argIndex], "-quantize") ) {
+      argIndex++;
+      quantize_scale = atof(argv[argIndex]);
+      if (quantize_scale <= 0) {
+        cerr << "ERROR: quantize scale must be positive." << endl;
+        exit(1);
+      }
+    }
     else if ( !strcmp(argv[argIndex], "-seed") ) {
       argIndex++;
       seed =  atol( argv[argIndex] );
@@ -212,6 +335,7 @@ void parseArgs(int argc, char **argv)
     }
     else if ( !strcmp(argv[argIndex], "-verbosity") ) {
       argIndex++;
+      verbosity = atoi(argv[argIndex]);
     }
     else if ( !strcmp(argv[argIndex], "-h") || !strcmp(argv[argIndex], "-help") ) {
       cout << endl
@@ -219,6 +343,24 @@ void parseArgs(int argc, char **argv)
            << endl
            << "   -timelimit          Timelimit in seconds (default None)" << endl
            << "   -seed               Random seed" << endl
+           << "   -nocanon            Keep duplicate factors as separate tables" << endl
+           << "   -nonormalize        Keep the raw log10 tables in the objective" << endl
+           << "   -quantize           Scale log10 tables by this factor and round" << endl
+           << "   -encoding           binary (default) or onehot bits for domains > 2" << endl
+           << "   -trws               TRW-S message passing: the MAP at -number 0 (minimum cut if submodular), else an upper bound" << endl
+           << "   -randomstart        MIP start at a random point of the parity coset, not near the MAP" << endl
+           << "   -mipstart           File of assignments to start from, e.g. of other parity levels" << endl
+           << "   -upper-cutoff       Known upper bound (log10) on the optimum" << endl
+           << "   -stop-above         Stop once a solution is above this value (log10)" << endl
+           << "   -stop-below-bound   Stop once the upper bound is below this value (log10)" << endl
+           << "   -verbosity          0: one result line only (time is total elapsed wall time), 1: log (default), 2: also parity matrices and TRW-S iterations" << endl
+           << "   -progress-file      Stream elapsed time, solution, bound and gap to this file" << endl
+           << "   -progress-fd        Same, to an open file descriptor" << endl
+           << "   -save-solution      Write the best assignment to this file" << endl
+           << "   -nographcut         Use the MIP even for submodular models without parity constraints" << endl
+           << "   -noqpbo             Skip the roof duality presolve of binary pairwise models" << endl
+           << "   -components         Split into connected components written to <prefix>.c<k>.uai" << endl
+           << "   -exactstates        Sum out components with at most this many states (default 2^20)" << endl
            << endl;
       // print parity constraint options usage
       //printParityUsage(cout);
@@ -243,8 +385,10 @@ double median(vector<double> &v)
     return v[n];
 }
 
-void print_matrix (vector <vector <bool> > A)
+void print_matrix (const vector <vector <bool> > & A)
 {
+if (verbosity < 2)
+	return;
 for (unsigned int i =0;i<A.size();i++)
 	{
 		for (unsigned int j =0;j<A[i].size();j++)					// last column is for coefficients b
@@ -581,64 +725,6 @@ vector <vector <bool> > generate_matrix_maxlength(int m, int n, int k)
 	return A;	
 }
 
-vector <vector <bool> > generate_Toeplitz_matrix(int m, int n)
-{
-	
-	vector <vector <bool> > A;
-	if (m==0)
-		return A;
-		
-	A.resize(m);
-	int i;
-	for (i =0;i<m;i++)
-	{
-	A[i].resize(n+1);
-	}
-	
-	// first column
-	for (i =0;i<m;i++)
-	{
-		if (rand()%2==0)
-			A[i][0] = true;
-		else
-			A[i][0]=false;
-		for (int j =1;j<m-i;j++)
-			if (j<n)
-				A[i+j][j] = A[i][0];
-	}
-	
-		// last column
-	for (i =0;i<m;i++)
-	{
-		if (rand()%2==0)
-			A[i][n] = true;
-		else
-			A[i][n]=false;
-
-	}
-
-
-	
-	// first row
-	for (int j =1;j<n;j++)
-	{
-		if (rand()%2==0)
-			A[0][j] = true;
-		else
-			A[0][j]=false;
-			
-		for (i =1;i<m;i++)
-			if (j+i<n)
-				A[i][j+i] = A[0][j];
-	}
-	
-	// print
-	//cout << "Random matrix3" <<endl;
-	//print_matrix(A);
-	
-	return A;	
-}
-
 typedef std::set<int> set_type;
 typedef std::set<set_type> powerset_type;
  
@@ -776,6 +862,279 @@ for (size_t i = 0;i<m;i++)
 return B;	
 }
 
+// adds c*indicator to the objective; a log10(0) entry forbids the indicator
+void add_cost_term(IloModel & model, IloNumExpr & objexpr, IloNum c, IloNumExpr indicator)
+{
+  if (isfinite(c)) {
+    if (c!=0)					// normalized tables have zero entries
+      objexpr += c*indicator;
+  }
+  else if (isinf(c) && c<0)
+    model.add((indicator==0));
+  else {
+    cout << "Cannot generate ILP"<< endl;
+    exit(-1);
+  }
+}
+
+// joint-state indicators of a sorted scope, one per table entry (last
+// variable changes fastest). Created on first use, with every variable's
+// state indicators equal to the corresponding sums of joint indicators.
+std::vector< IloBoolVar > & scope_marginal(std::map < std::vector< int>, std::vector< IloBoolVar> > & marginals,
+	const std::vector< int> & scope, const std::vector< int> & domains,
+	std::vector < std::vector< IloNumExpr > > & state, IloEnv env, IloModel & model)
+{
+  std::map < std::vector< int>, std::vector< IloBoolVar> >::iterator found = marginals.find(scope);
+  if (found!=marginals.end())
+    return found->second;
+
+  std::vector< IloBoolVar > & mu = marginals[scope];
+  size_t size = 1;
+  for (size_t v=0; v<scope.size(); v++)
+    size *= domains[scope[v]];
+
+  std::vector < std::vector< IloNumExpr > > sums(scope.size());
+  for (size_t v=0; v<scope.size(); v++)
+    for (int a=0; a<domains[scope[v]]; a++)
+      sums[v].push_back(IloNumExpr(env));
+
+  for (size_t t=0; t<size; t++) {
+    std::ostringstream name;
+    std::ostringstream values;
+    name << "mu";
+    size_t rest = t;
+    std::vector< int> x(scope.size());
+    for (int v=(int) scope.size()-1; v>=0; v--) {
+      x[v] = rest % domains[scope[v]];
+      rest /= domains[scope[v]];
+    }
+    for (size_t v=0; v<scope.size(); v++) {
+      name << "_" << scope[v];
+      values << (v ? "," : "") << x[v];
+    }
+    name << " (" << values.str() << ")";
+    char *cname = new char[name.str().size()+1];
+    strcpy(cname, name.str().c_str());
+    IloBoolVar mu_t (env, 0, 1, cname);					// (18)
+    model.add(mu_t);
+    mu.push_back(mu_t);
+    for (size_t v=0; v<scope.size(); v++)
+      sums[v][x[v]] += mu_t;
+  }
+
+  // local polytope: the joint indicators agree with the states
+  for (size_t v=0; v<scope.size(); v++)
+    for (int a=0; a<domains[scope[v]]; a++)
+      model.add((sums[v][a]==state[scope[v]][a]));
+  return mu;
+}
+
+// constrains the joint indicators of scope to sum up to those of sub, a subset of scope
+void tie_to_marginal(const std::vector< IloBoolVar > & mu, const std::vector< int> & scope,
+	const std::vector< IloBoolVar > & mu_sub, const std::vector< int> & sub,
+	const std::vector< int> & domains, IloModel & model, IloEnv env)
+{
+  std::vector< IloNumExpr > sums;
+  for (size_t s=0; s<mu_sub.size(); s++)
+    sums.push_back(IloNumExpr(env));
+
+  for (size_t t=0; t<mu.size(); t++) {
+    // index of the restriction of joint state t to sub
+    size_t rest = t;
+    std::vector< int> x(scope.size());
+    for (int v=(int) scope.size()-1; v>=0; v--) {
+      x[v] = rest % domains[scope[v]];
+      rest /= domains[scope[v]];
+    }
+    size_t index = 0;
+    size_t s = 0;
+    for (size_t v=0; v<scope.size(); v++)
+      if (s<sub.size() && sub[s]==scope[v]) {
+        index = index*domains[scope[v]] + x[v];
+        s++;
+      }
+    sums[index] += mu[t];
+  }
+  for (size_t s=0; s<mu_sub.size(); s++)
+    model.add((sums[s]==mu_sub[s]));
+}
+
+// log Z of independent components add up: small components are summed out
+// here, the others are written as separate instances for the caller to
+// estimate (in parallel) and add up
+void write_components(const FactorGraph &fg)
+{
+  vector<int> component;
+  int count = find_components(fg, component);
+
+  double constant = 0;
+  for (size_t l=0; l<fg.scopes.size(); l++)
+    if (fg.scopes[l].empty())
+      constant += fg.tables[l][0];
+
+  int written = 0;
+  double exact = constant;
+  cout << "Components = " << count << endl;
+  for (int c=0; c<count; c++) {
+    vector<int> variables;
+    FactorGraph sub = component_subgraph(fg, component, c, variables);
+    double states = 1;
+    for (int v=0; v<sub.nbvar; v++)
+      states *= sub.domains[v];
+
+    cout << "Component " << c << ": variables = " << sub.nbvar
+         << ", factors = " << sub.scopes.size();
+    if (states <= exact_states) {
+      double log10Z = exact_log10_partition(sub);
+      exact += log10Z;
+      cout << ", exact log10Z = " << log10Z << endl;
+    }
+    else {
+      char filename[1100];
+      sprintf(filename, "%s.c%d.uai", componentPrefix, c);
+      if (!write_uai(filename, sub)) {
+        cerr << "Could not write file " << filename << endl;
+        exit(EXIT_FAILURE);
+      }
+      written++;
+      cout << ", file = " << filename << endl;
+    }
+  }
+  cout << "Exact part log10Z = " << exact << " (constant factors " << constant << ")" << endl;
+  cout << "Components written = " << written << endl;
+}
+
+// one progress record per line: seconds since start, best solution and
+// upper bound (log10lik, -inf/inf if none yet) and their difference
+void report_progress(double incumbent, double bound)
+{
+  if (!progress_out)
+    return;
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  double elapsed = (now.tv_sec - start_time.tv_sec) + (now.tv_usec - start_time.tv_usec) * 1e-6;
+  fprintf(progress_out, "%.3f %.10g %.10g %.10g\n", elapsed, incumbent, bound, bound - incumbent);
+  fflush(progress_out);
+}
+
+// called by CPLEX during the search: streams the incumbent and bound when
+// they change (bound-only changes at most every 0.1s) and stops the search
+// as soon as the incumbent is above `above' or the best bound (or `known',
+// a bound from outside CPLEX) is below `below'. Values are in CPLEX
+// objective units, log10lik = value/scale + offset, up to error.
+class SearchCallbackI : public IloCplex::MIPInfoCallbackI {
+  IloNum above, below, known;
+  double scale, offset, error;
+  double last_incumbent, last_bound, last_time;
+public:
+  SearchCallbackI(IloEnv env, IloNum above, IloNum below, IloNum known,
+                  double scale, double offset, double error)
+    : IloCplex::MIPInfoCallbackI(env), above(above), below(below), known(known),
+      scale(scale), offset(offset), error(error),
+      last_incumbent(-INFINITY), last_bound(INFINITY), last_time(-1) {}
+  IloCplex::CallbackI *duplicateCallback() const {
+    return new (getEnv()) SearchCallbackI(*this);
+  }
+  void main() {
+    if (progress_out) {
+      double incumbent = hasIncumbent() ? getIncumbentObjValue()/scale + offset : -INFINITY;
+      double bound = min(getBestObjValue(), known)/scale + offset + error;
+      double now = getCplexTime() - getStartTime();
+      if (incumbent != last_incumbent || (bound != last_bound && now - last_time >= 0.1)) {
+        report_progress(incumbent, bound);
+        last_incumbent = incumbent;
+        last_bound = bound;
+        last_time = now;
+      }
+    }
+    if (hasIncumbent() && getIncumbentObjValue() > above) {
+      stop_reason = "solution above stop value";
+      abort();
+    }
+    else if (min(getBestObjValue(), known) < below) {
+      stop_reason = "upper bound below stop value";
+      abort();
+    }
+  }
+};
+
+// number of hashed bits of the MIP for these domains
+int hashed_bits(const vector<int> &domains)
+{
+  int n = 0;
+  for (size_t i=0; i<domains.size(); i++)
+    if (domains[i]==2)
+      n++;
+    else if (domains[i]>2 && onehot_encoding)
+      n += domains[i];
+    else
+      for (int k=0; (1<<k)<domains[i]; k++)
+        n++;
+  return n;
+}
+
+// with -verbosity 0 the only output, one line:
+//   Result: status log10lik upper_bound elapsed hashed_bits assignment
+// elapsed is the wall time in seconds since WH_cplex started, so it covers
+// reading the model, elimination, building the code and presolve as well
+// as the solve itself.
+// The assignment is its binary encoding (the hashed bits of -encoding
+// binary) in hex, every digit holding four bits, least significant first;
+// "-" if there is none. Infinite values are written as [-]Infinity.
+void print_result(const char *status, double value, double bound, int nbbits,
+                  const vector<int> &domains, const vector<int> &x)
+{
+  if (!result_out)
+    return;
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  double elapsed = (now.tv_sec - start_time.tv_sec) + (now.tv_usec - start_time.tv_usec) * 1e-6;
+
+  char line[256];
+  sprintf(line, "Result: %s %.10g %.10g %.3f %d ", status, value, bound, elapsed, nbbits);
+  std::string record(line);
+  for (size_t p; (p = record.find("inf")) != std::string::npos; )
+    record.replace(p, 3, "Infinity");
+  if (x.empty())
+    record += "-";
+  else {
+    vector<int> bit_var, bit_pos;
+    encoding_bits(domains, bit_var, bit_pos);
+    for (size_t j=0; j<bit_var.size() || j==0; j+=4) {
+      int digit = 0;
+      for (size_t k=j; k<j+4 && k<bit_var.size(); k++)
+        digit |= ((x[bit_var[k]] >> bit_pos[k]) & 1) << (k-j);
+      record += "0123456789abcdef"[digit];
+    }
+  }
+  *result_out << record << endl;
+}
+
+// reports a MAP found without CPLEX, in the format of the MIP output.
+// upper_bound is INFINITY if x is known to be optimal.
+void print_solution(const FactorGraph &fg, const vector<int> &x, const char *status,
+                    double objective_scale, double objective_offset, double objective_error,
+                    double upper_bound)
+{
+  double value = evaluate(fg, x)/objective_scale + objective_offset;
+  double bound = isfinite(upper_bound) ? upper_bound : value + objective_error;
+  cout << "Solution status = " << status << endl;
+  cout << "Solution value log10lik = " << value << endl;
+  if (objective_error > 0)
+    cout << "Quantization error bound log10 = " << objective_error << endl;
+  if (isfinite(upper_bound))
+    cout << "Upper bound log10lik = " << upper_bound << endl;
+  cout << "number of variables = " << hashed_bits(fg.domains) << endl;
+  cout << "Values = [";
+  for (int i=0; i<fg.nbvar; i++)
+    cout << (i ? ", " : "") << x[i];
+  cout << "]" << endl;
+  if (solutionFile[0] && !write_assignment(solutionFile, x))
+    cerr << "Could not write " << solutionFile << endl;
+  report_progress(value, bound);
+  print_result(status, value, bound, hashed_bits(fg.domains), fg.domains, x);
+}
+
 IloCP IlogSolver;
 
 // Usage: iloglue problem_name.wcsp [verbosity]
@@ -785,6 +1144,7 @@ int main(int argc, char **argv)
   int nbvar,nbval,nbconstr;
   IloEnv env;
   IloTimer timer(env);
+  gettimeofday(&start_time, NULL);
     
   try {
     // first parse and remove parity-related command-line arguments
@@ -794,29 +1154,51 @@ int main(int argc, char **argv)
     // now parse regular arguments
     parseArgs(argc, argv);
 
+    // a sparse matrix sets the number of parity constraints
+    if (matrixFile[0]) {
+      if (!read_sparse_matrix(matrixFile, sparseMatrix)) {
+        cerr << "ERROR: could not read the parity matrix " << matrixFile << endl;
+        exit(1);
+      }
+      // a nested family gives the code of -number checks, if given
+      if (!sparseMatrix.merges.empty() && parity_number > 0) {
+        if (!select_nested_level(sparseMatrix, parity_number)) {
+          cerr << "ERROR: the nested family in " << matrixFile << " has fewer than " << parity_number << " checks" << endl;
+          exit(1);
+        }
+      }
+      parity_number = sparseMatrix.rows.size();
+    }
+
+    // quiet mode: everything but the result line goes nowhere
+    if (verbosity <= 0) {
+      result_out = new std::ostream(cout.rdbuf());
+      cout.rdbuf(NULL);
+    }
+
     // associate the CP solver with the environment
     IlogSolver = IloCP(env);
 
     // associate a model with the environment
     IloModel model(env);
         
-    // open the instance file
-    ifstream file(instanceName);
-    if (!file) {
+    // read the instance; tables are stored as log10 potentials
+    FactorGraph fg;
+    if (!read_uai(instanceName, fg, pbname)) {
       cerr << "Could not open file " << instanceName << endl;
       exit(EXIT_FAILURE);
     }
   
     // stefano mod, read uai file
     // reads uai file to parse domain sizes; creates variables along the way
-    cerr << "Creating variables"<< endl;
-    file >> pbname;
-    file >> nbvar;
+    if (verbosity > 0)
+      cerr << "Creating variables"<< endl;
+    nbvar = fg.nbvar;
     IloIntVarArray vars(env, nbvar, 0, 100);
     nbval = 0;
     int tmp;
     for (int i=0; i<nbvar; i++) {
-      file >> tmp;
+      tmp = fg.domains[i];
       if (tmp>nbval)
         nbval = tmp;
       vars[i].setBounds(0, tmp-1);									// (17)
@@ -825,46 +1207,194 @@ int main(int argc, char **argv)
       vars[i].setName(name);
     }
     model.add(vars);
-    file >> nbconstr;
-    cerr << "Var:"<< nbvar <<" max dom size:" <<nbval<<" constraints:"<<nbconstr << endl;
+    nbconstr = fg.scopes.size();
+    if (verbosity > 0)
+      cerr << "Var:"<< nbvar <<" max dom size:" <<nbval<<" constraints:"<<nbconstr << endl;
+
+    // merge factors on the same scope before building the model
+    if (merge_factors) {
+      canonicalize_factors(fg, true);
+      nbconstr = fg.scopes.size();
+    }
+    else
+      sort_scopes(fg);
+
+    if (split_components) {
+      write_components(fg);
+      env.end();
+      return 0;
+    }
+
+    // TRW-S on the raw log10 tables: at -number 0 it replaces the MIP, with
+    // parity constraints its dual bound still bounds the constrained MAP. A
+    // submodular model at -number 0 is left to the exact minimum cut below.
+    std::vector<int> trws_x;
+    double known_bound = use_cutoff ? upper_cutoff : INFINITY;
+    if (use_trws && use_graphcut && parity_number == 0 && is_submodular(fg))
+      cout << "Submodular model, TRW-S skipped for the minimum cut" << endl;
+    else if (use_trws) {
+      double trws_primal, trws_bound;
+      if (!trws_map(fg, timelimit, 10000, trws_x, trws_primal, trws_bound, verbosity))
+        cerr << "TRW-S needs a pairwise model, skipped" << endl;
+      else if (parity_number == 0) {
+        bool closed = trws_bound - trws_primal <= 1e-9 * (1 + fabs(trws_primal));
+        print_solution(fg, trws_x, closed ? "Optimal" : "Feasible", 1, 0, 0, trws_bound);
+        env.end();
+        return 0;
+      }
+      else {
+        cout << "Upper bound log10lik = " << trws_bound << endl;
+        known_bound = min(known_bound, trws_bound);
+      }
+    }
+
+    // shift every table to a zero minimum and optionally make it integral
+    double objective_offset = 0;
+    double objective_scale = 1;
+    double objective_error = 0;
+    if (normalize_objective)
+      objective_offset = normalize_tables(fg);
+    if (quantize_scale > 0) {
+      objective_error = quantize_tables(fg, quantize_scale);
+      objective_scale = quantize_scale;
+    }
+
+    // the unconstrained MAP of a submodular binary model is a minimum cut
+    std::vector<int> map_assignment;
+    if (use_graphcut && parity_number == 0 && graphcut_map(fg, map_assignment)) {
+      cout << "Submodular model, MAP by minimum cut" << endl;
+      print_solution(fg, map_assignment, "Optimal", objective_scale, objective_offset, objective_error, INFINITY);
+      env.end();
+      return 0;
+    }
+
+    // roof duality: persistent variables of the unconstrained MAP become
+    // constants, and if all of them are persistent the MAP is already known.
+    // With parity constraints the persistencies do not hold, only the bound is reported.
+    std::vector<int> fixed(nbvar, -1);
+    double qpbo_bound;
+    if (use_qpbo && qpbo_presolve(fg, fixed, qpbo_bound)) {
+      int labeled = 0;
+      for (int i=0; i<nbvar; i++)
+        if (fixed[i]>=0)
+          labeled++;
+      cout << "QPBO persistencies: " << labeled << " of " << nbvar << " variables" << endl;
+      cout << "QPBO upper bound log10lik = " << qpbo_bound/objective_scale + objective_offset << endl;
+      if (parity_number > 0)
+        fixed.assign(nbvar, -1);
+      else if (labeled == nbvar) {
+        print_solution(fg, fixed, "Optimal", objective_scale, objective_offset, objective_error, INFINITY);
+        env.end();
+        return 0;
+      }
+    }
+    else
+      fixed.assign(nbvar, -1);
 
     // define variable that captures the value of the objective function
     IloIntVar obj(env, 0, IloIntMax, "objective");
 
 
       // use a native CP Optimizer representation of the .uai file
-      // read in variable scopes of CPT tables
-      std::vector < std::vector< int> > scopes;
-      int arity;
-      for (int i=0; i<nbconstr; i++) {
-        file >> arity;
-		std::vector< int> scope;
-		int id;
-        for (int j=0; j<arity; j++) {
-          file >> id;
-          scope.push_back(id);
-        }
-		scopes.push_back(scope);
-      }
-      // read in values of CPT tables
+      // variable scopes of CPT tables
+      std::vector < std::vector< int> > scopes = fg.scopes;
+      // values of CPT tables
       IloInt l;
       IloArray<IloNumArray> cost(env);
-      int TableSize;
       for (int i=0; i<nbconstr; i++) {
-        file >> TableSize;
-        double prod;
-        IloNum entry;
         IloNumArray table(env);
-        for (int j=0; j<TableSize; j++) {
-          file >> prod;				
-          entry = log10(prod);		// integer vs real
-          //entry = 10;		// integer vs real
-        //  cout << "adding " << entry << endl;
-          table.add(entry);
-        }
+        for (size_t j=0; j<fg.tables[i].size(); j++)
+          table.add(fg.tables[i][j]);
         cost.add(table);
       }
       cout << "done reading CPTs"<< endl;
+
+      // hashed bits and state indicators of every variable. A binary variable
+      // is its own bit; a larger domain gets one indicator per value, tied to
+      // ceil(log2 d) bits (or, with -encoding onehot, hashed directly).
+      IloIntVarArray bits(env);
+      std::vector < std::vector< IloNumExpr > > state(nbvar);
+      for (int i=0; i<nbvar; i++) {
+        int d = fg.domains[i];
+        if (d==1) {
+          state[i].push_back(IloNumExpr(env, 1));
+          continue;
+        }
+        if (d==2) {
+          bits.add(vars[i]);
+          if (fixed[i]>=0) {
+            vars[i].setBounds(fixed[i], fixed[i]);
+            state[i].push_back(IloNumExpr(env, 1-fixed[i]));
+            state[i].push_back(IloNumExpr(env, fixed[i]));
+            continue;
+          }
+          state[i].push_back(1-vars[i]);
+          state[i].push_back(vars[i]);
+          continue;
+        }
+        std::vector< IloBoolVar > indicators;
+        IloNumExpr sum_to_one(env);
+        IloNumExpr value(env);
+        for (int a=0; a<d; a++) {
+          char *name = new char[32];
+          sprintf(name, "s_%d_%d", i, a);
+          IloBoolVar s_i_a (env, 0, 1, name);
+          model.add(s_i_a);
+          indicators.push_back(s_i_a);
+          state[i].push_back(s_i_a);
+          sum_to_one += s_i_a;
+          value += a*s_i_a;
+        }
+        model.add((sum_to_one==1));
+        model.add((vars[i]==value));
+        if (onehot_encoding) {
+          for (int a=0; a<d; a++)
+            bits.add(indicators[a]);
+        }
+        else {
+          for (int k=0; (1<<k)<d; k++) {
+            char *name = new char[32];
+            sprintf(name, "x%d_b%d", i, k);
+            IloBoolVar b_i_k (env, 0, 1, name);
+            model.add(b_i_k);
+            IloNumExpr bit_value(env);
+            for (int a=0; a<d; a++)
+              if ((a>>k) & 1)
+                bit_value += indicators[a];
+            model.add((b_i_k==bit_value));
+            bits.add(b_i_k);
+          }
+        }
+      }
+      int nbbits = bits.getSize();
+      cout << "Hashed bits: " << nbbits << endl;
+
+      // factors sharing two or more variables are tied through a marginal over
+      // the intersection of their scopes, so the linearization of a k-ary
+      // factor only needs its own table plus these shared lower-order marginals
+      std::vector < std::set< std::vector< int> > > sub_scopes(nbconstr);
+      std::vector < std::vector< size_t> > factors_of_var(nbvar);
+      for (size_t f=0; f<(size_t) nbconstr; f++)
+        if (scopes[f].size()>=2)
+          for (size_t v=0; v<scopes[f].size(); v++)
+            factors_of_var[scopes[f][v]].push_back(f);
+      for (size_t v=0; v<(size_t) nbvar; v++)
+        for (size_t p=0; p<factors_of_var[v].size(); p++)
+          for (size_t q=p+1; q<factors_of_var[v].size(); q++) {
+            size_t f = factors_of_var[v][p];
+            size_t g = factors_of_var[v][q];
+            std::vector< int> common;
+            std::set_intersection(scopes[f].begin(), scopes[f].end(), scopes[g].begin(), scopes[g].end(),
+                                  std::back_inserter(common));
+            if (common.size()<2 || common[0]!=(int) v)		// count every pair once, at its first common variable
+              continue;
+            if (common.size()<scopes[f].size())
+              sub_scopes[f].insert(common);
+            if (common.size()<scopes[g].size())
+              sub_scopes[g].insert(common);
+          }
+      std::map < std::vector< int>, std::vector< IloBoolVar> > marginals;
+
       // define cost expression
       IloNumExpr objexpr(env);
 	  std::vector < std::vector< std::vector < std::vector< IloBoolVar> > > > Mu;
@@ -873,195 +1403,85 @@ int main(int argc, char **argv)
 	  for (size_t q= 0; q<nbvar;q++)
 			Mu[q].resize(nbvar);
 			
-      for (l = 0; l < nbconstr; l++) {        
-        IloIntExpr pos(env);			// init to 0
-	
-	
-	
-	if (scopes[l].size()==1)
+      for (l = 0; l < nbconstr; l++) {
+	if (scopes[l].size()==0)
 	{
-	//objexpr += cost[l][0]* vars[scopes[l][0]]+cost[l][1]* (1-vars[scopes[l][0]]);
-	
-	if (isfinite(cost[l][0]))
-		objexpr += cost[l][0]* (1-vars[scopes[l][0]]);
-	else
-		{
-		if isinf(cost[l][0])
-			{
-			model.add(vars[scopes[l][0]]==1);
-			}
-		else
-			{
-			cout << "Cannot generate ILP"<< endl;
-			exit(-1);
-			}
-		}
-	
-	if (isfinite(cost[l][1]))
-		objexpr += cost[l][1]* (vars[scopes[l][0]]);
-	else
-		{
-		if isinf(cost[l][1])
-			{
-			model.add(vars[scopes[l][0]]==0);
-			}
-		else
-			{
-			cout << "Cannot generate ILP"<< endl;
-			exit(-1);
-			}
-		}
-	
+		add_cost_term(model, objexpr, cost[l][0], IloNumExpr(env, 1));
+	}
+	else if (scopes[l].size()==1)
+	{
+		int i = scopes[l][0];
+		for (int a=0; a<fg.domains[i]; a++)
+			add_cost_term(model, objexpr, cost[l][a], state[i][a]);
 	}
 	else
 	{
-			int i = scopes[l][0];
-			int j = scopes[l][1];
-			
-			char *name = new char[32];
-			sprintf(name, "mu_%d_%d (0,0)", (int) i, (int) j);
-			IloBoolVar mu_i_j_0_0 (env, 0, 1, name);					// (18)
-			model.add(mu_i_j_0_0);
-			
-			sprintf(name, "mu_%d_%d (0,1)", (int) i, (int) j);
-			IloBoolVar mu_i_j_0_1 (env, 0, 1, name);					// (18)
-			model.add(mu_i_j_0_1);
-			
-			sprintf(name, "mu_%d_%d (1,0)", (int) i, (int) j);
-			IloBoolVar mu_i_j_1_0 (env, 0, 1, name);
-			model.add(mu_i_j_1_0);
-			
-			sprintf(name, "mu_%d_%d (1,1)", (int) i, (int) j);
-			IloBoolVar mu_i_j_1_1 (env, 0, 1, name);
-			model.add(mu_i_j_1_1);
-			
-			model.add((mu_i_j_0_0+mu_i_j_1_0 == 1-vars[j]));
-			//model.add((mu_i_j_0_0+mu_i_j_1_0 <= vars[j]));
-			
-			model.add((mu_i_j_0_1+mu_i_j_1_1 == vars[j]));
-			//model.add((mu_i_j_0_1+mu_i_j_1_1 <= 1-vars[j]));
-			
-			model.add((mu_i_j_0_0+mu_i_j_0_1 == 1-vars[i]));
-			//model.add((mu_i_j_0_0+mu_i_j_0_1 <= 1-vars[i]));
-			
-			model.add((mu_i_j_1_0+mu_i_j_1_1 == vars[i]));
-			//model.add((mu_i_j_1_0+mu_i_j_1_1 <= vars[i]));
-			
-			
-			model.add((mu_i_j_0_1+mu_i_j_1_1 <= 1));
-			model.add((mu_i_j_0_0+mu_i_j_1_0 <= 1));
-			model.add((mu_i_j_1_0+mu_i_j_1_1 <= 1));
-			model.add((mu_i_j_0_0+mu_i_j_0_1 <= 1));
-			
-			
-			Mu[i][j].resize(2);
-			Mu[i][j][0].resize(2);
-			Mu[i][j][1].resize(2);
-			Mu[i][j][0][0]= mu_i_j_0_0 ;
-			Mu[i][j][0][1]= mu_i_j_0_1 ;
-			Mu[i][j][1][0]= mu_i_j_1_0 ;
-			Mu[i][j][1][1]= mu_i_j_1_1 ;
-			
+		// joint indicators of the factor, shared with any factor on the same scope
+		std::vector< IloBoolVar > & mu = scope_marginal(marginals, scopes[l], fg.domains, state, env, model);
+		for (size_t t=0; t<mu.size(); t++)
+			add_cost_term(model, objexpr, cost[l][t], mu[t]);
 		
+		// overlapping factors agree on the marginal of their common variables
+		for (std::set< std::vector<int> >::iterator it=sub_scopes[l].begin(); it!=sub_scopes[l].end(); ++it)
+			tie_to_marginal(mu, scopes[l], scope_marginal(marginals, *it, fg.domains, state, env, model), *it, fg.domains, model, env);
 		
-		//objexpr += cost[l][0]* mu_i_j_0_0;
-		
-		if (isfinite(cost[l][0]))
-			objexpr += cost[l][0]* mu_i_j_0_0;
-		else
+		if (scopes[l].size()==2 && Mu[scopes[l][0]][scopes[l][1]].empty())
 		{
-		if isinf(cost[l][0])
-			{
-			model.add(mu_i_j_0_0==0);
-			}
-		else
-			{
-			cout << "Cannot generate ILP"<< endl;
-			exit(-1);
-			}
-		}	
-		
-		//objexpr += cost[l][1]* mu_i_j_0_1;
-		
-		if (isfinite(cost[l][1]))
-			objexpr += cost[l][1]* mu_i_j_0_1;
-		else
-		{
-		if isinf(cost[l][1])
-			{
-			model.add(mu_i_j_0_1==0);
-			}
-		else
-			{
-			cout << "Cannot generate ILP"<< endl;
-			exit(-1);
-			}
-		}
-		
-		
-		//objexpr +=cost[l][2]* mu_i_j_1_0;
-		
-		if (isfinite(cost[l][2]))
-			objexpr +=cost[l][2]* mu_i_j_1_0;
-		else
-		{
-		if isinf(cost[l][2])
-			{
-			model.add(mu_i_j_1_0==0);
-			}
-		else
-			{
-			cout << "Cannot generate ILP"<< endl;
-			exit(-1);
-			}
-		}
-		
-		//objexpr += cost[l][3]* mu_i_j_1_1;	
-
-		if (isfinite(cost[l][3]))
-			objexpr += cost[l][3]* mu_i_j_1_1;	
-		else
-		{
-		if isinf(cost[l][3])
-			{
-			model.add(mu_i_j_1_1==0);
-			}
-		else
-			{
-			cout << "Cannot generate ILP"<< endl;
-			exit(-1);
-			}
+			int i = scopes[l][0];
+			int j = scopes[l][1];
+			Mu[i][j].resize(fg.domains[i]);
+			for (int a=0; a<fg.domains[i]; a++)
+				for (int b=0; b<fg.domains[j]; b++)
+					Mu[i][j][a].push_back(mu[a*fg.domains[j]+b]);
 		}
-
-		
-				
-	//	objexpr += cost[l][0]* ((vars[scopes[l][0]]<=0)&&(vars[scopes[l][1]]<=0))+ cost[l][1]* ((vars[scopes[l][0]]<=0)&&(vars[scopes[l][1]]>=1))+cost[l][2]* ((vars[scopes[l][0]]>=1)&&(vars[scopes[l][1]]<=0))+ cost[l][3]* ((vars[scopes[l][0]]>=1)&&(vars[scopes[l][1]]>=1));
 	}
-     //   for (unsigned j=0; j<scopes[l].size(); j++) {
-     //     pos += ((int) pow(2.0,(double) scopes[l].size()-1-j))*vars[scopes[l][j]];
-	//	}
-       // objexpr +=cost[l][pos];
       }
-      // make obj, the variable capturing the objective, equal this cost expression
-    //  model.add(obj == objexpr);
 	  
 
 model.add(IloMaximize(env, objexpr ));
 
+// no assignment can beat the cutoff; the slack covers the quantization error
+// and the six digits the cutoff was printed with
+if (use_cutoff)
+	model.add(objexpr <= ((upper_cutoff - objective_offset) + objective_error + 1e-5*(1+fabs(upper_cutoff)))*objective_scale);
+
 if (!use_given_seed) seed = get_seed();
 srand(seed);
 
 // generate matrix of coefficients A x = b. b is the last column
 
-// vector <vector <bool> > A = generate_Toeplitz_matrix(parity_number, nbvar);
+// vector <vector <bool> > A = generate_Toeplitz_matrix(parity_number, nbbits);
 // cout << "here" << endl;
 // vector <vector <bool> > A = generate_matrix(parity_number, nbvar);
 
 vector <vector <bool> > A;
 if(externalParity)
-	A = parseMatrix(parity_number, nbvar);
+	A = parseMatrix(matrixStr, parity_number, nbbits);
+else if(matrixFile[0])
+{
+	if (sparseMatrix.n != nbbits)
+	{
+		cerr << "ERROR: the parity matrix has " << sparseMatrix.n << " columns for " << nbbits << " hashed bits" << endl;
+		exit(1);
+	}
+	A = expand_sparse_matrix(sparseMatrix, shuffle_columns);
+}
+else if(!pegSpec.empty() && parity_number > 0)
+{
+	if (!generate_peg_matrix(pegSpec.c_str(), parity_number, nbbits, peg_seed, pegCache.c_str(), peg_nested, sparseMatrix))
+	{
+		cerr << "ERROR: cannot build a PEG code of " << parity_number << " checks over " << nbbits << " hashed bits from " << pegSpec << endl;
+		exit(1);
+	}
+	A = expand_sparse_matrix(sparseMatrix, shuffle_columns);
+}
 else
-	A = generate_Toeplitz_matrix(parity_number, nbvar);
+	A = generate_Toeplitz_matrix(parity_number, nbbits);
+if (!offsetStr.empty() && !set_offsets(A, offsetStr))
+{
+	cerr << "ERROR: -offset needs one 0/1 per parity constraint" << endl;
+	exit(1);
+}
 
 if (!A.empty())
 {
@@ -1133,6 +1553,50 @@ for (int i=0; i<2; i++)
 //}
 }
 
+// MIP start: the unconstrained MAP guess (TRW-S if it ran) moved onto the
+// coset and repaired, instead of the random feasiblesol of row_echelon
+std::vector<int> start_x, start_bits;
+bool have_start = false;
+// assignments of other parity levels satisfy other constraints: they are
+// moved onto this coset the same way
+std::vector< std::vector<int> > given_starts;
+if (mipstartFile[0] && !read_assignments(mipstartFile, fg.domains, given_starts))
+	cerr << "Could not read all MIP starts from " << mipstartFile << endl;
+// the coset projection works on the binary encoding only: a one-hot
+// start of another level would violate this level's checks
+if (!A.empty() && onehot_encoding && !given_starts.empty())
+{
+	cerr << "MIP starts are not moved onto one-hot parity cosets, skipped" << endl;
+	given_starts.clear();
+}
+if (!A.empty() && !onehot_encoding)
+{
+	CosetBasis basis = reduce_coset(A);
+	std::vector<int> bit_var, bit_pos;
+	encoding_bits(fg.domains, bit_var, bit_pos);
+	if (basis.solvable)
+	{
+		std::vector< std::vector<int> > projected;
+		std::vector<int> given_bits;
+		for (size_t k=0; k<given_starts.size(); k++)
+			if (coset_start(fg, basis, bit_var, bit_pos, given_starts[k], given_bits))
+				projected.push_back(given_starts[k]);
+		given_starts.swap(projected);
+	}
+	if (basis.solvable && use_mipstart)
+	{
+		if (trws_x.empty())
+			map_guess(fg, 50, start_x);
+		else
+			start_x = trws_x;
+		icm(fg, start_x);
+		cout << "Unconstrained start log10lik = " << evaluate(fg, start_x)/objective_scale + objective_offset << endl;
+		have_start = coset_start(fg, basis, bit_var, bit_pos, start_x, start_bits);
+		if (have_start)
+			cout << "MIP start log10lik = " << evaluate(fg, start_x)/objective_scale + objective_offset << endl;
+	}
+}
+
 std::vector < std::set <size_t> > varAppearancesInXors;
 //varAppearancesInXors.resize(nbvar+1);						// dummy parity var
 
@@ -1261,15 +1725,15 @@ if (!A.empty())
 						// else
 							// model.add((zeta_sum_to_f==vars[i]));			// (14)
 							
-						if (i<nbvar)
-							model.add((zeta_sum_to_f==vars[i]));			// (14)							
+						if (i<nbbits)
+							model.add((zeta_sum_to_f==bits[i]));			// (14)							
 						else
-							if (i==nbvar)															// dummy
+							if (i==nbbits)															// dummy
 								model.add((zeta_sum_to_f==dummy_parity));			// (14)
 							else			// it's a pairwise
 								{
-								int i1 =(i - nbvar-1)/nbvar;
-								int j1 =(i - nbvar-1)%nbvar;
+								int i1 =(i - nbbits-1)/nbbits;
+								int j1 =(i - nbbits-1)%nbbits;
 								//cout << i << " -->" << i1 << " " << j1 << endl;
 								model.add((zeta_sum_to_f==Mu[i1][j1][0][1]+Mu[i1][j1][1][0]));			// (14)
 								}
@@ -1355,15 +1819,15 @@ for (size_t j= 0; j<A.size();j++)
 							// else
 								// fi_par_check_sum = fi_par_check_sum + vars[l];
 								
-							if (l<nbvar)
-								fi_par_check_sum = fi_par_check_sum + vars[l];		
+							if (l<nbbits)
+								fi_par_check_sum = fi_par_check_sum + bits[l];		
 							else
-								if (l==nbvar)															// dummy
+								if (l==nbbits)															// dummy
 								fi_par_check_sum = fi_par_check_sum +dummy_parity;
 								else			// it's a pairwise
 								{
-								int i1 =(l - nbvar-1)/nbvar;
-								int j1 =(l - nbvar-1)%nbvar;
+								int i1 =(l - nbbits-1)/nbbits;
+								int j1 =(l - nbbits-1)%nbbits;
 								//cout << l << " -->" << i1 << " " << j1 << endl;
 								fi_par_check_sum = fi_par_check_sum + Mu[i1][j1][0][1]+Mu[i1][j1][1][0];		
 								}
@@ -1384,15 +1848,15 @@ for (size_t j= 0; j<A.size();j++)
 							// else
 								// fi_par_check_sum = fi_par_check_sum + (1-vars[l]);
 								
-							if (l<nbvar)
-								fi_par_check_sum = fi_par_check_sum + (1-vars[l]);		
+							if (l<nbbits)
+								fi_par_check_sum = fi_par_check_sum + (1-bits[l]);		
 							else
-								if (l==nbvar)															// dummy
+								if (l==nbbits)															// dummy
 								fi_par_check_sum = fi_par_check_sum +(1-dummy_parity);
 								else			// it's a pairwise
 								{
-								int i1 =(l - nbvar-1)/nbvar;
-								int j1 =(l - nbvar-1)%nbvar;
+								int i1 =(l - nbbits-1)/nbbits;
+								int j1 =(l - nbbits-1)%nbbits;
 								//cout << l << " -->" << i1 << " " << j1 << endl;
 								fi_par_check_sum = fi_par_check_sum +(1- Mu[i1][j1][0][1]-Mu[i1][j1][1][0]);		
 								}								
@@ -1429,10 +1893,10 @@ for (size_t j= 0; j<A.size();j++)
 				for (it4 = variables_involved.begin ( ); it4 != variables_involved.end (); it4++)
 					{
 					int l = (*it4);
-					if (l==nbvar)
+					if (l==nbbits)
 						model.add((sum_over_S_fori[l]==dummy_parity));
 					else
-						model.add((sum_over_S_fori[l]==vars[l]));
+						model.add((sum_over_S_fori[l]==bits[l]));
 					}
 									
 				model.add((sum_w_over_S==1));					// (6)
@@ -1444,6 +1908,11 @@ for (size_t j= 0; j<A.size();j++)
 
 
 IloCplex cplex(model);
+	if (verbosity <= 0)
+	{
+		cplex.setOut(env.getNullStream());
+		cplex.setWarning(env.getNullStream());
+	}
 
 	if (timelimit > 0)
 		cplex.setParam(IloCplex::TiLim, timelimit);
@@ -1457,6 +1926,8 @@ IloCplex cplex(model);
 	//IlogSolver.setParameter(IloCP::LogPeriod, 1000000);
 	//IlogSolver.setParameter(IloCP::LogPeriod, 1);   // for debugging
 	cplex.setParam(IloCplex::Threads, 1);    // number of parallel threads
+	if (quantize_scale > 0)
+		cplex.setParam(IloCplex::ObjDif, 0.999);	// integral objective, only prune on strict improvements
 
 //	cplex.setParam(IloCplex::Threads, 4);    // number of parallel threads
  //    cplex.setParam(IloCplex::ParallelMode, -1);
@@ -1477,13 +1948,37 @@ IloCplex cplex(model);
 	//double [] feasibleinit;
 	IloNumVarArray startVar(env);
 	
-	for (size_t l= 0; l<nbvar;l++)
+	for (size_t l= 0; l<nbbits;l++)
 		{
-		startVar.add(vars[l]);
-		feasibleinit.add(feasiblesol[l]);
+		startVar.add(bits[l]);
+		feasibleinit.add(have_start ? start_bits[l] : feasiblesol[l]);
 		}
+	// the values of larger domains pin down their indicators and marginals
+	if (have_start)
+		for (int i=0; i<nbvar; i++)
+			if (fg.domains[i]>2)
+			{
+			startVar.add(vars[i]);
+			feasibleinit.add(start_x[i]);
+			}
 	cplex.addMIPStart(startVar, feasibleinit);
 	}
+	for (size_t k=0; k<given_starts.size(); k++)
+	{
+	IloNumArray givenVal(env);
+	for (int i=0; i<nbvar; i++)
+		givenVal.add(given_starts[k][i]);
+	cplex.addMIPStart(vars, givenVal);
+	}
+	// the stop values hold for the true objective, whatever the quantization
+	if (use_stop_above || use_stop_below || progress_out)
+	{
+		IloNum above = use_stop_above ? (stop_above - objective_offset + objective_error)*objective_scale : IloInfinity;
+		IloNum below = use_stop_below ? (stop_below - objective_offset - objective_error)*objective_scale : -IloInfinity;
+		IloNum known = isfinite(known_bound) ? (known_bound - objective_offset)*objective_scale : IloInfinity;
+		cplex.use(IloCplex::Callback(new (env) SearchCallbackI(env, above, below, known,
+		                                                        objective_scale, objective_offset, objective_error)));
+	}
 cout<<"----------------start solving----------------"<<endl;
 	cplex.solve();
       //if ( !cplex.solve() ) {
@@ -1493,16 +1988,46 @@ cout<<"----------------start solving----------------"<<endl;
 //cout << objexpr;
 cout<<"----------------end of solving----------------"<<endl;
      IloNumArray vals(env);
+      if (stop_reason)
+        env.out() << "Stop condition: " << stop_reason << endl;
       env.out() << "Solution status = " << cplex.getStatus() << endl;
+      std::ostringstream status_name;
+      status_name << cplex.getStatus();
+      if (cplex.getStatus() == IloAlgorithm::Infeasible) {
+        report_progress(-INFINITY, -INFINITY);
+        print_result(status_name.str().c_str(), -INFINITY, -INFINITY, nbbits, fg.domains, std::vector<int>());
+        env.end();
+        return 0;
+      }
+      double final_bound = min(known_bound, cplex.getBestObjValue()/objective_scale + objective_offset + objective_error);
+      if (cplex.getStatus() == IloAlgorithm::Unknown) {		// stopped before any solution
+        env.out() << "Upper bound log10lik = " << final_bound << endl;
+        report_progress(-INFINITY, final_bound);
+        print_result(status_name.str().c_str(), -INFINITY, final_bound, nbbits, fg.domains, std::vector<int>());
+        env.end();
+        return 0;
+      }
      // env.out() << "Solution value = " << cplex.getObjValue() << endl;
-      env.out() << "Solution value log10lik = " << cplex.getObjValue() << endl;
-      env.out() << "number of variables = " << nbvar << endl;
+      env.out() << "Solution value log10lik = " << cplex.getObjValue()/objective_scale + objective_offset << endl;
+      if (quantize_scale > 0)
+        env.out() << "Quantization error bound log10 = " << objective_error << endl;
+      env.out() << "Upper bound log10lik = " << final_bound << endl;
+      report_progress(cplex.getObjValue()/objective_scale + objective_offset, final_bound);
+      env.out() << "number of variables = " << nbbits << endl;		// hashed dimension
 
 	cplex.getValues(vals, vars);
       env.out() << "Values = " << vals << endl;
+	std::vector<int> best_x(nbvar);
+	for (int i=0; i<nbvar; i++)
+		best_x[i] = (int) floor(vals[i] + 0.5);
+	if (solutionFile[0] && !write_assignment(solutionFile, best_x))
+		cerr << "Could not write " << solutionFile << endl;
+	print_result(status_name.str().c_str(), cplex.getObjValue()/objective_scale + objective_offset, final_bound,
+	             nbbits, fg.domains, best_x);
 	
     } catch (IloException& ex) {
     cout << "Error: " << ex << endl;
+    print_result("Error", -INFINITY, INFINITY, 0, std::vector<int>(), std::vector<int>());
 
   }
 
@@ -0,0 +1,352 @@
+// Dual decomposition for the MAP under parity constraints, without CPLEX.
+//
+// The constrained problem max f(x) s.t. A x = b is split into the MRF f
+// and one slave per parity check, every check holding its own copy of the
+// bits it touches. Lagrange multipliers on the copies move linear cost
+// between the MRF and the checks:
+//
+//   L(lambda) = max_x [f(x) + sum_cj lambda_cj x_j] + sum_c max_{x^c even/odd} -sum_j lambda_cj x^c_j
+//
+// which is an upper bound for every lambda. The MRF slave is bounded by a
+// warm started TRW-S pass, a check slave is solved exactly by flipping its
+// cheapest bit if the parity is wrong. The multipliers follow a subgradient
+// with Polyak steps; primal points come from projecting the TRW-S rounding
+// onto the coset.
+
+#include <sys/time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <string>
+#include "factor_graph.h"
+#include "trws.h"
+#include "parity.h"
+
+using namespace std;
+
+int           parity_number  = 0;
+string        matrixStr;
+bool          externalParity = false;
+char          matrixFile[1024] = "";
+string        pegSpec;
+string        pegCache;
+unsigned long peg_seed       = 987654321u;
+int           peg_nested     = 0;
+bool          shuffle_columns = false;
+string        offsetStr;
+unsigned long seed;
+bool          use_given_seed = false;
+long          timelimit      = -1;
+int           max_iterations = 1000;
+int           verbosity      = 1;
+char          instanceName[1024];
+
+unsigned long get_seed(void) {
+  struct timeval tv;
+  struct timezone tzp;
+  gettimeofday(&tv,&tzp);
+  return (( tv.tv_sec & 0177 ) * 1000000) + tv.tv_usec;
+}
+
+double elapsed_since(const struct timeval &start)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) * 1e-6;
+}
+
+void parseArgs(int argc, char **argv)
+{
+  if (argc <= 1) {
+    cerr << "ERROR: instance name must be specified" << endl
+         << "       See usage (WH_dd -h)" << endl;
+    exit(1);
+  }
+
+  for (int argIndex=1; argIndex < argc; ++argIndex) {
+    if ( !strcmp(argv[argIndex], "-number") ) {
+      argIndex++;
+      parity_number = atoi(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-matrix") ) {
+      argIndex++;
+      matrixStr = string(argv[argIndex]);
+      externalParity = true;
+    }
+    else if ( !strcmp(argv[argIndex], "-matrix-file") ) {
+      argIndex++;
+      strcpy(matrixFile, argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-peg") ) {
+      argIndex++;
+      pegSpec = string(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-peg-cache") ) {
+      argIndex++;
+      pegCache = string(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-peg-nested") ) {
+      argIndex++;
+      peg_nested = atoi(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-peg-seed") ) {
+      argIndex++;
+      peg_seed = strtoul(argv[argIndex], NULL, 10);
+    }
+    else if ( !strcmp(argv[argIndex], "-matrix-shuffle") ) {
+      shuffle_columns = true;
+    }
+    else if ( !strcmp(argv[argIndex], "-offset") ) {
+      argIndex++;
+      offsetStr = string(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-timelimit") ) {
+      argIndex++;
+      timelimit = atol(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-iterations") ) {
+      argIndex++;
+      max_iterations = atoi(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-seed") ) {
+      argIndex++;
+      seed = atol(argv[argIndex]);
+      use_given_seed = true;
+    }
+    else if ( !strcmp(argv[argIndex], "-verbosity") ) {
+      argIndex++;
+      verbosity = atoi(argv[argIndex]);
+    }
+    else if ( !strcmp(argv[argIndex], "-paritylevel") ) {
+      argIndex++;				// accepted for WH_cplex command lines
+    }
+    else if ( !strcmp(argv[argIndex], "-skipelim") ) {
+    }
+    else if ( !strcmp(argv[argIndex], "-h") || !strcmp(argv[argIndex], "-help") ) {
+      cout << endl
+           << "USAGE: WH_dd [options] instance.uai" << endl
+           << endl
+           << "   -number             Number of parity constraints (default 0)" << endl
+           << "   -matrix             Parity matrix, rows of 0/1 separated by _" << endl
+           << "   -matrix-file        Sparse parity matrix in alist or compressed rows, - for stdin" << endl
+           << "   -peg                PEG code of -number checks: a MainPEG degree file, or d1:f1,d2:f2,..." << endl
+           << "   -peg-cache          Directory of cached PEG codes to look -peg codes up in or add them to" << endl
+           << "   -peg-nested         Take -peg codes from the nested family of the code of this many checks" << endl
+           << "   -peg-seed           Seed of the -peg code (default: MainPEG's)" << endl
+           << "   -matrix-shuffle     Randomly permute the columns of the -matrix-file or -peg matrix" << endl
+           << "   -offset             Parity b as a string of 0/1, one per row (default: random)" << endl
+           << "   -timelimit          Timelimit in seconds (default None)" << endl
+           << "   -iterations         Maximum number of subgradient steps (default 1000)" << endl
+           << "   -seed               Random seed" << endl
+           << "   -verbosity          1: log (default), 2: also every iteration" << endl
+           << endl;
+      exit(0);
+    }
+    else if (argv[argIndex][0] != '-') {
+      strcpy(instanceName, argv[argIndex]);
+    }
+    else {
+      cerr << "ERROR: Unexpected option: " << argv[argIndex] << endl
+           << "       See usage (WH_dd -h)" << endl;
+      exit(1);
+    }
+  }
+}
+
+// variable values from the bits of the binary encoding; false if a
+// variable ends up outside its domain
+bool decode_bits(const FactorGraph &fg, const vector<int> &bit_var, const vector<int> &bit_pos,
+                 const vector<int> &bits, vector<int> &x)
+{
+  x.assign(fg.nbvar, 0);
+  for (size_t j=0; j<bits.size(); j++)
+    x[bit_var[j]] |= bits[j] << bit_pos[j];
+  for (int i=0; i<fg.nbvar; i++)
+    if (x[i] >= fg.domains[i])
+      return false;
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  parseArgs(argc, argv);
+
+  FactorGraph fg;
+  char pbname[1024];
+  if (!read_uai(instanceName, fg, pbname)) {
+    cerr << "Could not open file " << instanceName << endl;
+    exit(EXIT_FAILURE);
+  }
+  canonicalize_factors(fg, true);
+  if (!is_pairwise(fg)) {
+    cerr << "Dual decomposition needs a pairwise model" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  vector<int> bit_var, bit_pos;
+  encoding_bits(fg.domains, bit_var, bit_pos);
+  int nbbits = bit_var.size();
+  cout << "Hashed bits: " << nbbits << endl;
+  // the bits of variable i are first_bit[i] .. first_bit[i+1]-1
+  vector<int> first_bit(fg.nbvar+1, nbbits);
+  for (int j=nbbits-1; j>=0; j--)
+    first_bit[bit_var[j]] = j;
+  for (int i=fg.nbvar-1; i>=0; i--)
+    if (first_bit[i] > first_bit[i+1])
+      first_bit[i] = first_bit[i+1];
+
+  // same random stream as WH_cplex for the same seed
+  if (!use_given_seed)
+    seed = get_seed();
+  srand(seed);
+  vector< vector<bool> > A;
+  SparseMatrix H;
+  if (externalParity)
+    A = parseMatrix(matrixStr, parity_number, nbbits);
+  else if (matrixFile[0]) {
+    if (!read_sparse_matrix(matrixFile, H)) {
+      cerr << "Could not read the parity matrix " << matrixFile << endl;
+      exit(EXIT_FAILURE);
+    }
+    if (H.n != nbbits) {
+      cerr << "The parity matrix has " << H.n << " columns for " << nbbits << " hashed bits" << endl;
+      exit(EXIT_FAILURE);
+    }
+    // a nested family gives the code of -number checks, if given
+    if (!H.merges.empty() && parity_number > 0 && !select_nested_level(H, parity_number)) {
+      cerr << "The nested family in " << matrixFile << " has fewer than " << parity_number << " checks" << endl;
+      exit(EXIT_FAILURE);
+    }
+    A = expand_sparse_matrix(H, shuffle_columns);
+  }
+  else if (!pegSpec.empty() && parity_number > 0) {
+    if (!generate_peg_matrix(pegSpec.c_str(), parity_number, nbbits, peg_seed, pegCache.c_str(), peg_nested, H)) {
+      cerr << "Cannot build a PEG code of " << parity_number << " checks over " << nbbits << " hashed bits from " << pegSpec << endl;
+      exit(EXIT_FAILURE);
+    }
+    A = expand_sparse_matrix(H, shuffle_columns);
+  }
+  else
+    A = generate_Toeplitz_matrix(parity_number, nbbits);
+  if (!offsetStr.empty() && !set_offsets(A, offsetStr)) {
+    cerr << "-offset needs one 0/1 per parity constraint" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  CosetBasis basis = reduce_coset(A);
+  if (!basis.solvable) {
+    cout << "Solution status = Infeasible" << endl;
+    return 0;
+  }
+
+  // support of every check and one multiplier per (check, bit)
+  int m = A.size();
+  vector< vector<int> > support(m);
+  vector< vector<double> > lambda(m);
+  for (int c=0; c<m; c++) {
+    for (int j=0; j<nbbits; j++)
+      if (A[c][j])
+        support[c].push_back(j);
+    lambda[c].assign(support[c].size(), 0);
+  }
+
+  TRWS trws(fg);
+  vector<double> bit_cost(nbbits);
+  vector<int> y, y_bits(nbbits), x_best, x;
+  vector< vector<int> > check_bits(m);
+  double primal = -INFINITY;
+  double upper_bound = INFINITY;
+  for (int iter=1; iter<=max_iterations; iter++) {
+    // MRF slave: f plus the multipliers as linear bit costs
+    bit_cost.assign(nbbits, 0);
+    for (int c=0; c<m; c++)
+      for (size_t k=0; k<support[c].size(); k++)
+        bit_cost[support[c][k]] += lambda[c][k];
+    for (int i=0; i<fg.nbvar; i++)
+      for (int a=0; a<fg.domains[i]; a++) {
+        double e = 0;
+        for (int j=first_bit[i]; j<first_bit[i+1]; j++)
+          if ((a >> bit_pos[j]) & 1)
+            e -= bit_cost[j];
+        trws.set_extra_energy(i, a, e);
+      }
+    double bound = -trws.iterate(y);
+    for (int j=0; j<nbbits; j++)
+      y_bits[j] = (y[bit_var[j]] >> bit_pos[j]) & 1;
+
+    // check slaves: best bits for -lambda, then fix the parity
+    for (int c=0; c<m; c++) {
+      check_bits[c].assign(support[c].size(), 0);
+      int parity = 0;
+      int cheapest = -1;
+      double best = 0;
+      for (size_t k=0; k<support[c].size(); k++) {
+        double w = -lambda[c][k];
+        if (w > 0) {
+          check_bits[c][k] = 1;
+          parity ^= 1;
+          best += w;
+        }
+        if (cheapest<0 || fabs(w)<fabs(lambda[c][cheapest]))
+          cheapest = k;
+      }
+      if (parity != (int) A[c][nbbits]) {
+        check_bits[c][cheapest] ^= 1;
+        best -= fabs(lambda[c][cheapest]);
+      }
+      bound += best;
+    }
+    upper_bound = min(upper_bound, bound);
+
+    // primal: project the MRF rounding onto the coset
+    vector<int> z(y_bits);
+    project_to_coset(basis, z);
+    if (decode_bits(fg, bit_var, bit_pos, z, x)) {
+      double value = evaluate(fg, x);
+      if (value > primal) {
+        primal = value;
+        x_best = x;
+      }
+    }
+
+    if (verbosity >= 2)
+      cout << "DD iteration " << iter << ": primal log10lik = " << primal
+           << ", upper bound log10lik = " << upper_bound << endl;
+    if (isfinite(primal) && upper_bound - primal <= 1e-9 * (1 + fabs(primal)))
+      break;
+    if (timelimit > 0 && elapsed_since(start) >= timelimit)
+      break;
+
+    // subgradient of L: MRF copy minus check copy
+    double norm = 0;
+    for (int c=0; c<m; c++)
+      for (size_t k=0; k<support[c].size(); k++) {
+        int g = y_bits[support[c][k]] - check_bits[c][k];
+        norm += g*g;
+      }
+    if (norm == 0)
+      continue;
+    double step = isfinite(primal) ? (bound - primal) / norm : 1.0 / sqrt((double) iter);
+    for (int c=0; c<m; c++)
+      for (size_t k=0; k<support[c].size(); k++)
+        lambda[c][k] -= step * (y_bits[support[c][k]] - check_bits[c][k]);
+  }
+
+  bool closed = isfinite(primal) && upper_bound - primal <= 1e-9 * (1 + fabs(primal));
+  cout << "Solution status = " << (closed ? "Optimal" : isfinite(primal) ? "Feasible" : "Unknown") << endl;
+  cout << "Solution value log10lik = " << primal << endl;
+  cout << "Upper bound log10lik = " << upper_bound << endl;
+  cout << "number of variables = " << nbbits << endl;
+  if (!x_best.empty()) {
+    cout << "Values = [";
+    for (int i=0; i<fg.nbvar; i++)
+      cout << (i ? ", " : "") << x_best[i];
+    cout << "]" << endl;
+  }
+  return 0;
+}
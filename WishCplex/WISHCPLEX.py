@@ -74,7 +74,8 @@ for i in range(0,depth+1):			## main for loop
 		sampnum=T
 	for t in range(1,sampnum+1):			## main for loop
 		outfilenamelog = "%s.xor%d.loglen%d.%d.ILOGLUE.uai.LOG" % (os.path.basename(fileName) , i , 0 , t)
-		cmdline = ("timeout %d ./WH_cplex -paritylevel 1 -number %d -seed 10 %s > %s") % (args.timeout , i , args.infile , args.outfolder +"/"+ outfilenamelog)
+		outfilenameprog = "%s.xor%d.loglen%d.%d.ILOGLUE.uai.PROG" % (os.path.basename(fileName) , i , 0 , t)
+		cmdline = ("timeout %d ./WH_cplex -paritylevel 1 -number %d -seed 10 -progress-file %s %s > %s") % (args.timeout , i , args.outfolder +"/"+ outfilenameprog , args.infile , args.outfolder +"/"+ outfilenamelog)
 		os.system(cmdline)
 		## Parallel execution:
 		##
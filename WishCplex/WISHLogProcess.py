@@ -147,6 +147,20 @@ def process_logs(folder):
 	pylab.savefig('cdf.plot.pdf')
 	pylab.show()
 
+# last record (best solution, upper bound) that WH_cplex streamed to the
+# .PROG file next to a log with -progress-file; None if there is none
+def last_progress(logfile):
+	progfile = logfile[:-len(".LOG")] + ".PROG"
+	if not os.path.exists(progfile):
+		return None
+	last = None
+	with open(progfile, 'r') as f:
+		for l in f:
+			fields = l.split()
+			if len(fields)==4:
+				last = (float(fields[1]), float(fields[2]))
+	return last
+
 def process_logs_cplex_LB(folder):
 	w=[]
 	Samples=[] 
@@ -168,6 +182,7 @@ def process_logs_cplex_LB(folder):
 				with open(files, 'r') as f:
 					 #check if solved to optimality
 					 lines = f.read()
+					 progress = last_progress(files)
 					 #entries = re.search("Optimum: (\d+) log10like: ([-+]?(\d+(\.\d*)?|\.\d+)([eE][-+]?\d+)?) prob: ([-+]?(\d+(\.\d*)?|\.\d+)([eE][-+]?\d+)?) in (\d+) backtracks and (\d+) nodes and ([-+]?(\d+(\.\d*)?|\.\d+)([eE][-+]?\d+)?) seconds", lines)
 					 entriesoo = re.search("Solution status = Optimal", lines)
 					 entries = re.search("Solution value log10lik = ([-+]?(\d+(\.\d*)?|\.\d+)([eE][-+]?\d+)?)", lines)
@@ -178,6 +193,8 @@ def process_logs_cplex_LB(folder):
 						entriesSol = re.search("Optimal solution: (\d+)", lines)
 						if entriesSol is not None:
 							Samples.append([i,t,float(entries.group(1)),True,entriesSol.group(1)])
+					 elif progress is not None and progress[0]>float("-inf"):
+						w.append([i,t,progress[0],False])		# best solution when the run ended
 					 else:
 						entries2 = re.findall("\n(\s+)(\d+)(\s+)(\d+)(\s+)([-+]?\d+\.\d+)(\s+)(\d+)(\s+)(\s+|[-+]?\d+\.\d+)(\s+)([-+]?\d+\.\d+)", lines)
 						if entries2:
@@ -270,6 +287,7 @@ def process_logs_cplex_UB(folder):
 				with open(files, 'r') as f:
 					 #check if solved to optimality
 					 lines = f.read()
+					 progress = last_progress(files)
 					 entries = re.search("Solution value log10lik = ([-+]?(\d+(\.\d*)?|\.\d+)([eE][-+]?\d+)?)", lines)
 					 entriesoo = re.search("Solution status = Optimal", lines)
 					 if entries is not None and entriesoo is not None:
@@ -277,6 +295,8 @@ def process_logs_cplex_UB(folder):
 						entriesSol = re.search("Optimal solution: (\d+)", lines)
 						if entriesSol is not None:
 							Samples.append([i,t,float(entries.group(1)),True,entriesSol.group(1)])
+					 elif progress is not None and progress[1]<float("inf"):
+						w.append([i,t,progress[1],False])		# bound when the run ended
 					 else:
 
 						entries2 = re.findall("\n(\s+)(\d+)(\s+)(\d+)(\s+)([-+]?\d+\.\d+)(\s+)(\d+)(\s+)(\s+|[-+]?\d+\.\d+)(\s+)([-+]?\d+\.\d+)", lines)
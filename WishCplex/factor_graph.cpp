@@ -0,0 +1,358 @@
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <cmath>
+#include <iomanip>
+#include "factor_graph.h"
+
+using namespace std;
+
+bool read_uai(const char *filename, FactorGraph &fg, char *pbname)
+{
+  ifstream file(filename);
+  if (!file)
+    return false;
+
+  file >> pbname;
+  file >> fg.nbvar;
+  fg.domains.resize(fg.nbvar);
+  for (int i=0; i<fg.nbvar; i++)
+    file >> fg.domains[i];
+
+  int nbconstr;
+  file >> nbconstr;
+  fg.scopes.resize(nbconstr);
+  for (int i=0; i<nbconstr; i++) {
+    int arity;
+    file >> arity;
+    fg.scopes[i].resize(arity);
+    for (int j=0; j<arity; j++)
+      file >> fg.scopes[i][j];
+  }
+
+  fg.tables.resize(nbconstr);
+  for (int i=0; i<nbconstr; i++) {
+    int TableSize;
+    file >> TableSize;
+    fg.tables[i].resize(TableSize);
+    for (int j=0; j<TableSize; j++) {
+      double prod;
+      file >> prod;
+      fg.tables[i][j] = log10(prod);
+    }
+  }
+  return true;
+}
+
+// stride of each scope position in the table (last variable changes fastest)
+static vector<int> scope_strides(const vector<int> &scope, const vector<int> &domains)
+{
+  vector<int> strides(scope.size());
+  int s = 1;
+  for (int j=(int) scope.size()-1; j>=0; j--) {
+    strides[j] = s;
+    s *= domains[scope[j]];
+  }
+  return strides;
+}
+
+// reorders the scope by increasing variable index and permutes the table accordingly
+static void sort_scope(vector<int> &scope, vector<double> &table, const vector<int> &domains)
+{
+  size_t k = scope.size();
+  vector<size_t> order(k);
+  for (size_t j=0; j<k; j++)
+    order[j] = j;
+  for (size_t a=1; a<k; a++)			// insertion sort, scopes are short
+    for (size_t b=a; b>0 && scope[order[b]]<scope[order[b-1]]; b--)
+      swap(order[b], order[b-1]);
+
+  bool sorted = true;
+  for (size_t j=0; j<k; j++)
+    if (order[j]!=j)
+      sorted = false;
+  if (sorted)
+    return;
+
+  vector<int> newscope(k);
+  for (size_t j=0; j<k; j++)
+    newscope[j] = scope[order[j]];
+
+  vector<int> oldstrides = scope_strides(scope, domains);
+  vector<int> newstrides = scope_strides(newscope, domains);
+  vector<double> newtable(table.size());
+  for (size_t t=0; t<table.size(); t++) {
+    size_t index = 0;
+    for (size_t j=0; j<k; j++) {
+      int x = (t / oldstrides[order[j]]) % domains[scope[order[j]]];
+      index += x * newstrides[j];
+    }
+    newtable[index] = table[t];
+  }
+  scope.swap(newscope);
+  table.swap(newtable);
+}
+
+void sort_scopes(FactorGraph &fg)
+{
+  for (size_t l=0; l<fg.scopes.size(); l++)
+    sort_scope(fg.scopes[l], fg.tables[l], fg.domains);
+}
+
+void canonicalize_factors(FactorGraph &fg, bool fold_unary)
+{
+  size_t initial = fg.scopes.size();
+  vector< vector<int> > scopes;
+  vector< vector<double> > tables;
+  map< vector<int>, size_t > index_of_scope;
+  int merged = 0;
+
+  // sum the log tables of factors sharing a scope
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    sort_scope(fg.scopes[l], fg.tables[l], fg.domains);
+    map< vector<int>, size_t >::iterator it = index_of_scope.find(fg.scopes[l]);
+    if (it==index_of_scope.end()) {
+      index_of_scope[fg.scopes[l]] = scopes.size();
+      scopes.push_back(fg.scopes[l]);
+      tables.push_back(fg.tables[l]);
+    }
+    else {
+      vector<double> &table = tables[it->second];
+      for (size_t t=0; t<table.size(); t++)
+        table[t] += fg.tables[l][t];
+      merged++;
+    }
+  }
+
+  // fold unary tables into the smallest adjacent factor. Unary tables with
+  // zero entries are kept, they become bound fixings in the model.
+  int folded = 0;
+  vector<bool> removed(scopes.size(), false);
+  if (fold_unary) {
+    vector< vector<size_t> > adjacent(fg.nbvar);
+    for (size_t l=0; l<scopes.size(); l++)
+      if (scopes[l].size()>=2)
+        for (size_t j=0; j<scopes[l].size(); j++)
+          adjacent[scopes[l][j]].push_back(l);
+
+    for (size_t l=0; l<scopes.size(); l++) {
+      if (scopes[l].size()!=1)
+        continue;
+      int v = scopes[l][0];
+      bool finite = true;
+      for (size_t t=0; t<tables[l].size(); t++)
+        if (!isfinite(tables[l][t]))
+          finite = false;
+      if (!finite || adjacent[v].empty())
+        continue;
+
+      size_t target = adjacent[v][0];
+      for (size_t a=1; a<adjacent[v].size(); a++)
+        if (tables[adjacent[v][a]].size()<tables[target].size())
+          target = adjacent[v][a];
+
+      vector<int> strides = scope_strides(scopes[target], fg.domains);
+      size_t pos = find(scopes[target].begin(), scopes[target].end(), v) - scopes[target].begin();
+      for (size_t t=0; t<tables[target].size(); t++)
+        tables[target][t] += tables[l][(t / strides[pos]) % fg.domains[v]];
+      removed[l] = true;
+      folded++;
+    }
+  }
+
+  fg.scopes.clear();
+  fg.tables.clear();
+  for (size_t l=0; l<scopes.size(); l++)
+    if (!removed[l]) {
+      fg.scopes.push_back(scopes[l]);
+      fg.tables.push_back(tables[l]);
+    }
+
+  cout << "Canonical factors: " << initial << " -> " << fg.scopes.size()
+       << " (merged " << merged << ", folded unary " << folded << ")" << endl;
+}
+
+double normalize_tables(FactorGraph &fg)
+{
+  double offset = 0;
+  int zeros = 0;
+  for (size_t l=0; l<fg.tables.size(); l++) {
+    vector<double> &table = fg.tables[l];
+    bool found = false;
+    double minimum = 0;
+    for (size_t t=0; t<table.size(); t++)
+      if (isfinite(table[t]) && (!found || table[t]<minimum)) {
+        minimum = table[t];
+        found = true;
+      }
+    if (!found)
+      continue;
+    for (size_t t=0; t<table.size(); t++) {
+      table[t] -= minimum;
+      if (table[t]==0)
+        zeros++;
+    }
+    offset += minimum;
+  }
+  cout << "Normalized tables: offset log10 = " << offset << ", zero entries = " << zeros << endl;
+  return offset;
+}
+
+double quantize_tables(FactorGraph &fg, double scale)
+{
+  // an assignment picks one entry per table, so the per-table worst cases add up
+  double bound = 0;
+  for (size_t l=0; l<fg.tables.size(); l++) {
+    vector<double> &table = fg.tables[l];
+    double worst = 0;
+    for (size_t t=0; t<table.size(); t++) {
+      if (!isfinite(table[t]))
+        continue;
+      double rounded = floor(table[t]*scale + 0.5);
+      worst = max(worst, fabs(rounded - table[t]*scale));
+      table[t] = rounded;
+    }
+    bound += worst/scale;
+  }
+  cout << "Quantized tables: scale = " << scale << ", error bound log10 = " << bound << endl;
+  return bound;
+}
+
+double evaluate(const FactorGraph &fg, const vector<int> &x)
+{
+  double value = 0;
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    size_t index = 0;
+    for (size_t j=0; j<fg.scopes[l].size(); j++)
+      index = index*fg.domains[fg.scopes[l][j]] + x[fg.scopes[l][j]];
+    value += fg.tables[l][index];
+  }
+  return value;
+}
+
+static int find_root(vector<int> &parent, int v)
+{
+  while (parent[v]!=v) {
+    parent[v] = parent[parent[v]];
+    v = parent[v];
+  }
+  return v;
+}
+
+int find_components(const FactorGraph &fg, vector<int> &component)
+{
+  vector<int> parent(fg.nbvar);
+  for (int v=0; v<fg.nbvar; v++)
+    parent[v] = v;
+  for (size_t l=0; l<fg.scopes.size(); l++)
+    for (size_t j=1; j<fg.scopes[l].size(); j++) {
+      int a = find_root(parent, fg.scopes[l][0]);
+      int b = find_root(parent, fg.scopes[l][j]);
+      if (a!=b)
+        parent[max(a, b)] = min(a, b);
+    }
+
+  // number components by their smallest variable
+  component.assign(fg.nbvar, -1);
+  int count = 0;
+  vector<int> label(fg.nbvar, -1);
+  for (int v=0; v<fg.nbvar; v++) {
+    int root = find_root(parent, v);
+    if (label[root]<0)
+      label[root] = count++;
+    component[v] = label[root];
+  }
+  return count;
+}
+
+FactorGraph component_subgraph(const FactorGraph &fg, const vector<int> &component, int c,
+                               vector<int> &variables)
+{
+  FactorGraph sub;
+  vector<int> renumber(fg.nbvar, -1);
+  variables.clear();
+  for (int v=0; v<fg.nbvar; v++)
+    if (component[v]==c) {
+      renumber[v] = variables.size();
+      variables.push_back(v);
+      sub.domains.push_back(fg.domains[v]);
+    }
+  sub.nbvar = variables.size();
+
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    if (fg.scopes[l].empty() || component[fg.scopes[l][0]]!=c)
+      continue;
+    vector<int> scope(fg.scopes[l].size());
+    for (size_t j=0; j<scope.size(); j++)
+      scope[j] = renumber[fg.scopes[l][j]];
+    sub.scopes.push_back(scope);
+    sub.tables.push_back(fg.tables[l]);
+  }
+  return sub;
+}
+
+bool write_uai(const char *filename, const FactorGraph &fg)
+{
+  ofstream file(filename);
+  if (!file)
+    return false;
+
+  file << "MARKOV" << endl << fg.nbvar << endl;
+  for (int v=0; v<fg.nbvar; v++)
+    file << fg.domains[v] << (v+1<fg.nbvar ? " " : "");
+  file << endl << fg.scopes.size() << endl;
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    file << fg.scopes[l].size();
+    for (size_t j=0; j<fg.scopes[l].size(); j++)
+      file << " " << fg.scopes[l][j];
+    file << endl;
+  }
+  file << setprecision(17);
+  for (size_t l=0; l<fg.tables.size(); l++) {
+    file << endl << fg.tables[l].size() << endl;
+    for (size_t t=0; t<fg.tables[l].size(); t++)
+      file << pow(10.0, fg.tables[l][t]) << endl;
+  }
+  return true;
+}
+
+double exact_log10_partition(const FactorGraph &fg)
+{
+  // odometer over the joint states, accumulating 10^(sum - shift)
+  vector<int> x(fg.nbvar, 0);
+  vector< vector<int> > strides(fg.scopes.size());
+  for (size_t l=0; l<fg.scopes.size(); l++)
+    strides[l] = scope_strides(fg.scopes[l], fg.domains);
+
+  double shift = 0;
+  bool shifted = false;
+  double sum = 0;
+  while (true) {
+    double value = 0;
+    for (size_t l=0; l<fg.scopes.size(); l++) {
+      size_t index = 0;
+      for (size_t j=0; j<fg.scopes[l].size(); j++)
+        index += x[fg.scopes[l][j]] * strides[l][j];
+      value += fg.tables[l][index];
+    }
+    if (isfinite(value)) {
+      if (!shifted || value>shift) {
+        sum = (shifted ? sum*pow(10.0, shift-value) : 0) + 1;
+        shift = value;
+        shifted = true;
+      }
+      else
+        sum += pow(10.0, value-shift);
+    }
+
+    int v = 0;
+    while (v<fg.nbvar && ++x[v]==fg.domains[v])
+      x[v++] = 0;
+    if (v==fg.nbvar)
+      break;
+  }
+  if (!shifted)
+    return -INFINITY;
+  return shift + log10(sum);
+}
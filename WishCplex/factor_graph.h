@@ -0,0 +1,53 @@
+#ifndef FACTOR_GRAPH_H
+#define FACTOR_GRAPH_H
+
+#include <vector>
+
+// A graphical model as read from a .uai file. Tables hold log10 of the
+// potentials and are indexed as in the file: the last variable of a scope
+// changes fastest.
+struct FactorGraph {
+  int nbvar;
+  std::vector<int> domains;
+  std::vector< std::vector<int> > scopes;
+  std::vector< std::vector<double> > tables;
+};
+
+// reads a MARKOV .uai file; returns false if the file cannot be opened
+bool read_uai(const char *filename, FactorGraph &fg, char *pbname);
+
+// reorders every scope by increasing variable index, permuting its table
+void sort_scopes(FactorGraph &fg);
+
+// sorts every scope, sums the tables of factors with identical scopes and
+// (if fold_unary) adds finite unary tables into an adjacent factor
+void canonicalize_factors(FactorGraph &fg, bool fold_unary);
+
+// subtracts the smallest finite entry of every table so that at least one
+// entry per table is zero; returns the total removed, which has to be added
+// back to objective values
+double normalize_tables(FactorGraph &fg);
+
+// multiplies every finite entry by scale and rounds it to an integer; returns
+// a bound on the error of the (unscaled) objective of any assignment
+double quantize_tables(FactorGraph &fg, double scale);
+
+// sum of the tables at the full assignment x
+double evaluate(const FactorGraph &fg, const std::vector<int> &x);
+
+// labels every variable with its connected component (union-find over the
+// factor scopes); returns the number of components
+int find_components(const FactorGraph &fg, std::vector<int> &component);
+
+// the factors of component c, with its variables renumbered from 0;
+// variables[k] is the original index of variable k
+FactorGraph component_subgraph(const FactorGraph &fg, const std::vector<int> &component, int c,
+                               std::vector<int> &variables);
+
+// writes the model as a MARKOV .uai file (tables converted back from log10)
+bool write_uai(const char *filename, const FactorGraph &fg);
+
+// log10 of the partition function by enumerating all joint states
+double exact_log10_partition(const FactorGraph &fg);
+
+#endif
@@ -0,0 +1,66 @@
+#include <cmath>
+#include <algorithm>
+#include "maxflow.h"
+#include "graphcut.h"
+
+using namespace std;
+
+bool is_submodular(const FactorGraph &fg)
+{
+  for (int v=0; v<fg.nbvar; v++)
+    if (fg.domains[v]!=2)
+      return false;
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    const vector<double> &table = fg.tables[l];
+    if (fg.scopes[l].size()>2 || (fg.scopes[l].size()==2 && fg.scopes[l][0]==fg.scopes[l][1]))
+      return false;
+    for (size_t t=0; t<table.size(); t++)
+      if (!isfinite(table[t]))
+        return false;
+    if (fg.scopes[l].size()==2 && table[0]+table[3] < table[1]+table[2])
+      return false;
+  }
+  return true;
+}
+
+// E = -sum of the tables; a pair term A + (C-A) x_p + (D-C) x_q +
+// (B+C-A-D) (1-x_p) x_q becomes the edge p->q, cut when x_p = 0 and x_q = 1
+bool graphcut_map(const FactorGraph &fg, vector<int> &x)
+{
+  if (!is_submodular(fg))
+    return false;
+
+  int n = fg.nbvar;
+  MaxFlow graph(n);
+  vector<double> theta0(n, 0), theta1(n, 0);
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    const vector<int> &scope = fg.scopes[l];
+    const vector<double> &table = fg.tables[l];
+    if (scope.size()==1) {
+      theta0[scope[0]] -= table[0];
+      theta1[scope[0]] -= table[1];
+    }
+    else if (scope.size()==2) {
+      int p = scope[0], q = scope[1];
+      double A = -table[0], B = -table[1], C = -table[2], D = -table[3];
+      theta1[p] += C-A;
+      theta1[q] += D-C;
+      graph.add_edge(p, q, B+C-A-D, 0);
+    }
+  }
+
+  // x_p = 0 is the source side
+  for (int p=0; p<n; p++) {
+    double delta = theta1[p] - theta0[p];
+    if (delta > 0)
+      graph.add_tweights(p, delta, 0);
+    else if (delta < 0)
+      graph.add_tweights(p, 0, -delta);
+  }
+  graph.maxflow();
+
+  x.resize(n);
+  for (int p=0; p<n; p++)
+    x[p] = graph.in_source_set(p) ? 0 : 1;
+  return true;
+}
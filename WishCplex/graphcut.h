@@ -0,0 +1,16 @@
+#ifndef GRAPHCUT_H
+#define GRAPHCUT_H
+
+#include <vector>
+#include "factor_graph.h"
+
+// true if every variable is binary, every factor has arity <= 2 and finite
+// entries, and every pairwise table satisfies t(0,0)+t(1,1) >= t(0,1)+t(1,0)
+// (the energy -t is submodular)
+bool is_submodular(const FactorGraph &fg);
+
+// exact MAP of a submodular binary pairwise model as a single s-t minimum
+// cut; returns false, leaving x untouched, if the model is not submodular
+bool graphcut_map(const FactorGraph &fg, std::vector<int> &x);
+
+#endif
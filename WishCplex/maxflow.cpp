@@ -0,0 +1,245 @@
+#include <algorithm>
+#include "maxflow.h"
+
+using namespace std;
+
+// special values of Node::parent
+static const int FREE = -1;
+static const int TERMINAL = -2;
+static const int ORPHAN = -3;
+
+MaxFlow::MaxFlow(int n)
+{
+  Node empty = { -1, FREE, false, false, 0, 0, 0 };
+  nodes.assign(n, empty);
+  flow = 0;
+  time = 0;
+}
+
+void MaxFlow::add_tweights(int i, double cap_source, double cap_sink)
+{
+  // the common part of both capacities is flow that is pushed right away
+  double delta = nodes[i].tr_cap;
+  if (delta > 0)
+    cap_source += delta;
+  else
+    cap_sink -= delta;
+  flow += min(cap_source, cap_sink);
+  nodes[i].tr_cap = cap_source - cap_sink;
+}
+
+void MaxFlow::add_edge(int i, int j, double cap, double rev_cap)
+{
+  Arc forward = { j, nodes[i].first, cap };
+  nodes[i].first = arcs.size();
+  arcs.push_back(forward);
+  Arc backward = { i, nodes[j].first, rev_cap };
+  nodes[j].first = arcs.size();
+  arcs.push_back(backward);
+}
+
+void MaxFlow::set_active(int i)
+{
+  if (!nodes[i].active) {
+    nodes[i].active = true;
+    active_nodes.push_back(i);
+  }
+}
+
+bool MaxFlow::in_source_set(int i) const
+{
+  return nodes[i].parent != FREE && !nodes[i].is_sink;
+}
+
+// walks up from j to its terminal; d gets the distance. Nodes on a valid
+// path are stamped with the current time so later walks stop early.
+bool MaxFlow::origin_is_terminal(int j, int &d)
+{
+  d = 0;
+  for (int k=j; ; ) {
+    if (nodes[k].ts == time) {
+      d += nodes[k].dist;
+      break;
+    }
+    int a = nodes[k].parent;
+    d++;
+    if (a == TERMINAL) {
+      nodes[k].ts = time;
+      nodes[k].dist = 1;
+      break;
+    }
+    if (a == ORPHAN || a == FREE)
+      return false;
+    k = arcs[a].head;
+  }
+  int dist = d;
+  for (int k=j; nodes[k].ts != time; k = arcs[nodes[k].parent].head) {
+    nodes[k].ts = time;
+    nodes[k].dist = dist--;
+  }
+  return true;
+}
+
+// pushes the bottleneck capacity along source -> ... -> tail(a) -> head(a) -> ... -> sink
+void MaxFlow::augment(int a)
+{
+  double bottleneck = arcs[a].r_cap;
+  for (int i = arcs[a^1].head; ; ) {
+    int pa = nodes[i].parent;
+    if (pa == TERMINAL) {
+      bottleneck = min(bottleneck, nodes[i].tr_cap);
+      break;
+    }
+    bottleneck = min(bottleneck, arcs[pa^1].r_cap);
+    i = arcs[pa].head;
+  }
+  for (int i = arcs[a].head; ; ) {
+    int pa = nodes[i].parent;
+    if (pa == TERMINAL) {
+      bottleneck = min(bottleneck, -nodes[i].tr_cap);
+      break;
+    }
+    bottleneck = min(bottleneck, arcs[pa].r_cap);
+    i = arcs[pa].head;
+  }
+
+  arcs[a].r_cap -= bottleneck;
+  arcs[a^1].r_cap += bottleneck;
+  // saturated tree arcs turn their children into orphans
+  for (int i = arcs[a^1].head; ; ) {
+    int pa = nodes[i].parent;
+    if (pa == TERMINAL) {
+      nodes[i].tr_cap -= bottleneck;
+      if (nodes[i].tr_cap == 0) {
+        nodes[i].parent = ORPHAN;
+        orphans.push_back(i);
+      }
+      break;
+    }
+    arcs[pa^1].r_cap -= bottleneck;
+    arcs[pa].r_cap += bottleneck;
+    int next = arcs[pa].head;
+    if (arcs[pa^1].r_cap == 0) {
+      nodes[i].parent = ORPHAN;
+      orphans.push_back(i);
+    }
+    i = next;
+  }
+  for (int i = arcs[a].head; ; ) {
+    int pa = nodes[i].parent;
+    if (pa == TERMINAL) {
+      nodes[i].tr_cap += bottleneck;
+      if (nodes[i].tr_cap == 0) {
+        nodes[i].parent = ORPHAN;
+        orphans.push_back(i);
+      }
+      break;
+    }
+    arcs[pa].r_cap -= bottleneck;
+    arcs[pa^1].r_cap += bottleneck;
+    int next = arcs[pa].head;
+    if (arcs[pa].r_cap == 0) {
+      nodes[i].parent = ORPHAN;
+      orphans.push_back(i);
+    }
+    i = next;
+  }
+  flow += bottleneck;
+}
+
+// finds a new parent for i in its own tree, or frees it
+void MaxFlow::process_orphan(int i)
+{
+  bool sink = nodes[i].is_sink;
+  int best = -1;
+  int best_dist = 0;
+  for (int a = nodes[i].first; a != -1; a = arcs[a].next) {
+    double cap = sink ? arcs[a].r_cap : arcs[a^1].r_cap;
+    int j = arcs[a].head;
+    int d;
+    if (cap > 0 && nodes[j].parent != FREE && nodes[j].is_sink == sink
+        && origin_is_terminal(j, d) && (best == -1 || d < best_dist)) {
+      best = a;
+      best_dist = d;
+    }
+  }
+  if (best != -1) {
+    nodes[i].parent = best;
+    nodes[i].ts = time;
+    nodes[i].dist = best_dist + 1;
+    return;
+  }
+
+  for (int a = nodes[i].first; a != -1; a = arcs[a].next) {
+    int j = arcs[a].head;
+    int pj = nodes[j].parent;
+    if (pj == FREE || nodes[j].is_sink != sink)
+      continue;
+    double cap = sink ? arcs[a].r_cap : arcs[a^1].r_cap;
+    if (cap > 0)
+      set_active(j);
+    if (pj >= 0 && arcs[pj].head == i) {
+      nodes[j].parent = ORPHAN;
+      orphans.push_back(j);
+    }
+  }
+  nodes[i].parent = FREE;
+}
+
+double MaxFlow::maxflow()
+{
+  for (size_t i=0; i<nodes.size(); i++)
+    if (nodes[i].tr_cap != 0) {
+      nodes[i].parent = TERMINAL;
+      nodes[i].is_sink = nodes[i].tr_cap < 0;
+      nodes[i].ts = time;
+      nodes[i].dist = 1;
+      set_active(i);
+    }
+
+  while (!active_nodes.empty()) {
+    int i = active_nodes.front();
+    if (nodes[i].parent == FREE) {
+      active_nodes.pop_front();
+      nodes[i].active = false;
+      continue;
+    }
+
+    // grow the tree of i until it touches the other tree
+    int path = -1;
+    for (int a = nodes[i].first; a != -1 && path == -1; a = arcs[a].next) {
+      double cap = nodes[i].is_sink ? arcs[a^1].r_cap : arcs[a].r_cap;
+      if (cap <= 0)
+        continue;
+      int j = arcs[a].head;
+      if (nodes[j].parent == FREE) {
+        nodes[j].is_sink = nodes[i].is_sink;
+        nodes[j].parent = a^1;
+        nodes[j].ts = nodes[i].ts;
+        nodes[j].dist = nodes[i].dist + 1;
+        set_active(j);
+      }
+      else if (nodes[j].is_sink != nodes[i].is_sink)
+        path = nodes[i].is_sink ? a^1 : a;
+      else if (nodes[j].ts <= nodes[i].ts && nodes[j].dist > nodes[i].dist) {
+        nodes[j].parent = a^1;
+        nodes[j].ts = nodes[i].ts;
+        nodes[j].dist = nodes[i].dist + 1;
+      }
+    }
+    if (path == -1) {
+      active_nodes.pop_front();
+      nodes[i].active = false;
+      continue;
+    }
+
+    time++;
+    augment(path);
+    while (!orphans.empty()) {
+      int o = orphans.front();
+      orphans.pop_front();
+      process_orphan(o);
+    }
+  }
+  return flow;
+}
@@ -0,0 +1,54 @@
+#ifndef MAXFLOW_H
+#define MAXFLOW_H
+
+#include <vector>
+#include <deque>
+
+// Boykov-Kolmogorov max-flow on a graph with terminal edges, as used for
+// graph-cut energy minimization. Capacities are doubles; the source and sink
+// are implicit and connected through add_tweights.
+class MaxFlow {
+public:
+  MaxFlow(int nodes);
+
+  // capacities source->i and i->sink (added to the existing ones)
+  void add_tweights(int i, double cap_source, double cap_sink);
+  // edge i->j with capacity cap and j->i with capacity rev_cap
+  void add_edge(int i, int j, double cap, double rev_cap);
+
+  double maxflow();
+
+  // after maxflow: true if i is reachable from the source in the residual
+  // graph, i.e. on the source side of the minimum cut
+  bool in_source_set(int i) const;
+
+private:
+  struct Arc {
+    int head;
+    int next;					// next arc out of the same node
+    double r_cap;				// residual capacity
+  };
+  struct Node {
+    int first;					// first outgoing arc
+    int parent;					// arc to the parent, or FREE/TERMINAL/ORPHAN
+    bool is_sink;				// tree membership when parent != FREE
+    bool active;
+    int ts;					// time stamp of dist
+    int dist;					// distance to the terminal
+    double tr_cap;				// >0: residual source->i, <0: residual i->sink
+  };
+
+  std::vector<Node> nodes;
+  std::vector<Arc> arcs;			// arcs 2k and 2k+1 are sisters
+  std::deque<int> active_nodes;
+  std::deque<int> orphans;
+  double flow;
+  int time;
+
+  void set_active(int i);
+  bool origin_is_terminal(int j, int &d);
+  void augment(int a);
+  void process_orphan(int i);
+};
+
+#endif
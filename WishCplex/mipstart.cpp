@@ -0,0 +1,235 @@
+#include <cmath>
+#include <cstdio>
+#include "mipstart.h"
+#include "trws.h"
+
+using namespace std;
+
+static vector< vector<int> > factors_of_vars(const FactorGraph &fg)
+{
+  vector< vector<int> > factors(fg.nbvar);
+  for (size_t l=0; l<fg.scopes.size(); l++)
+    for (size_t j=0; j<fg.scopes[l].size(); j++)
+      if (j==0 || fg.scopes[l][j]!=fg.scopes[l][j-1])
+        factors[fg.scopes[l][j]].push_back(l);
+  return factors;
+}
+
+// adds the entry of factor l at x to value, or counts it in bad if it is a
+// zero potential or some variable is outside its domain
+static void add_factor(const FactorGraph &fg, int l, const vector<int> &x, int &bad, double &value)
+{
+  size_t index = 0;
+  for (size_t j=0; j<fg.scopes[l].size(); j++) {
+    int v = fg.scopes[l][j];
+    if (x[v]>=fg.domains[v]) {
+      bad++;
+      return;
+    }
+    index = index*fg.domains[v] + x[v];
+  }
+  double entry = fg.tables[l][index];
+  if (isfinite(entry))
+    value += entry;
+  else
+    bad++;
+}
+
+static bool better(int bad, double value, int old_bad, double old_value)
+{
+  return bad<old_bad || (bad==old_bad && value > old_value + 1e-9*(1+fabs(old_value)));
+}
+
+void icm(const FactorGraph &fg, vector<int> &x)
+{
+  vector< vector<int> > factors = factors_of_vars(fg);
+  bool improved = true;
+  for (int pass=0; improved && pass<100; pass++) {
+    improved = false;
+    for (int i=0; i<fg.nbvar; i++) {
+      int current = x[i];
+      int best = current, best_bad = 0;
+      double best_value = 0;
+      for (size_t k=0; k<factors[i].size(); k++)
+        add_factor(fg, factors[i][k], x, best_bad, best_value);
+      for (int a=0; a<fg.domains[i]; a++) {
+        if (a==current)
+          continue;
+        x[i] = a;
+        int bad = 0;
+        double value = 0;
+        for (size_t k=0; k<factors[i].size(); k++)
+          add_factor(fg, factors[i][k], x, bad, value);
+        if (better(bad, value, best_bad, best_value)) {
+          best = a;
+          best_bad = bad;
+          best_value = value;
+        }
+      }
+      x[i] = best;
+      if (best!=current)
+        improved = true;
+    }
+  }
+}
+
+void map_guess(const FactorGraph &fg, int iterations, vector<int> &x)
+{
+  x.assign(fg.nbvar, 0);
+  if (iterations>0 && is_pairwise(fg)) {
+    TRWS trws(fg);
+    vector<int> y;
+    double best = -INFINITY;
+    for (int iter=0; iter<iterations; iter++) {
+      trws.iterate(y);
+      double value = evaluate(fg, y);
+      if (iter==0 || value>best) {
+        best = value;
+        x = y;
+      }
+    }
+    return;
+  }
+
+  // max-marginal of every factor, summed per variable and value
+  vector< vector<double> > local(fg.nbvar);
+  for (int i=0; i<fg.nbvar; i++)
+    local[i].assign(fg.domains[i], 0);
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    const vector<int> &scope = fg.scopes[l];
+    vector< vector<double> > best(scope.size());
+    for (size_t j=0; j<scope.size(); j++)
+      best[j].assign(fg.domains[scope[j]], -INFINITY);
+    for (size_t t=0; t<fg.tables[l].size(); t++) {
+      size_t rest = t;
+      for (int j=scope.size()-1; j>=0; j--) {
+        int a = rest % fg.domains[scope[j]];
+        rest /= fg.domains[scope[j]];
+        best[j][a] = max(best[j][a], fg.tables[l][t]);
+      }
+    }
+    for (size_t j=0; j<scope.size(); j++)
+      for (int a=0; a<fg.domains[scope[j]]; a++)
+        local[scope[j]][a] += best[j][a];
+  }
+  for (int i=0; i<fg.nbvar; i++)
+    for (int a=1; a<fg.domains[i]; a++)
+      if (local[i][a]>local[i][x[i]])
+        x[i] = a;
+}
+
+bool coset_start(const FactorGraph &fg, const CosetBasis &basis,
+                 const vector<int> &bit_var, const vector<int> &bit_pos,
+                 vector<int> &x, vector<int> &bits)
+{
+  int nbbits = bit_var.size();
+  bits.resize(nbbits);
+  for (int j=0; j<nbbits; j++)
+    bits[j] = (x[bit_var[j]] >> bit_pos[j]) & 1;
+  project_to_coset(basis, bits);
+  for (int j=0; j<nbbits; j++)
+    x[bit_var[j]] &= ~(1 << bit_pos[j]);
+  for (int j=0; j<nbbits; j++)
+    x[bit_var[j]] |= bits[j] << bit_pos[j];
+
+  // flipping free bit j also flips the pivot of every row containing j
+  vector<bool> is_pivot(nbbits, false);
+  vector< vector<int> > moves(nbbits);
+  for (size_t r=0; r<basis.rows.size(); r++) {
+    is_pivot[basis.pivots[r]] = true;
+    for (int j=basis.pivots[r]+1; j<nbbits; j++)
+      if (basis.rows[r][j])
+        moves[j].push_back(basis.pivots[r]);
+  }
+  for (int j=0; j<nbbits; j++)
+    if (!is_pivot[j])
+      moves[j].push_back(j);
+
+  vector< vector<int> > factors = factors_of_vars(fg);
+  vector<int> var_stamp(fg.nbvar, -1), factor_stamp(fg.scopes.size(), -1);
+  vector<int> touched_vars, touched_factors;
+  int stamp = 0;
+  bool improved = true;
+  for (int pass=0; improved && pass<20; pass++) {
+    improved = false;
+    for (int j=0; j<nbbits; j++) {
+      if (is_pivot[j])
+        continue;
+      stamp++;
+      touched_vars.clear();
+      touched_factors.clear();
+      for (size_t k=0; k<moves[j].size(); k++) {
+        int v = bit_var[moves[j][k]];
+        if (var_stamp[v]==stamp)
+          continue;
+        var_stamp[v] = stamp;
+        touched_vars.push_back(v);
+        for (size_t f=0; f<factors[v].size(); f++)
+          if (factor_stamp[factors[v][f]]!=stamp) {
+            factor_stamp[factors[v][f]] = stamp;
+            touched_factors.push_back(factors[v][f]);
+          }
+      }
+
+      int old_bad = 0, bad = 0;
+      double old_value = 0, value = 0;
+      for (size_t k=0; k<touched_vars.size(); k++)
+        if (x[touched_vars[k]]>=fg.domains[touched_vars[k]])
+          old_bad++;
+      for (size_t k=0; k<touched_factors.size(); k++)
+        add_factor(fg, touched_factors[k], x, old_bad, old_value);
+      for (size_t k=0; k<moves[j].size(); k++) {
+        bits[moves[j][k]] ^= 1;
+        x[bit_var[moves[j][k]]] ^= 1 << bit_pos[moves[j][k]];
+      }
+      for (size_t k=0; k<touched_vars.size(); k++)
+        if (x[touched_vars[k]]>=fg.domains[touched_vars[k]])
+          bad++;
+      for (size_t k=0; k<touched_factors.size(); k++)
+        add_factor(fg, touched_factors[k], x, bad, value);
+
+      if (better(bad, value, old_bad, old_value))
+        improved = true;
+      else
+        for (size_t k=0; k<moves[j].size(); k++) {
+          bits[moves[j][k]] ^= 1;
+          x[bit_var[moves[j][k]]] ^= 1 << bit_pos[moves[j][k]];
+        }
+    }
+  }
+
+  for (int i=0; i<fg.nbvar; i++)
+    if (x[i]>=fg.domains[i])
+      return false;
+  return true;
+}
+
+bool read_assignments(const char *filename, const vector<int> &domains,
+                      vector< vector<int> > &assignments)
+{
+  FILE *f = fopen(filename, "rb");
+  if (!f)
+    return false;
+  int n;
+  bool ok = true;
+  while (ok && fread(&n, sizeof(int), 1, f)==1) {
+    vector<int> x(n > 0 ? n : 0);
+    ok = n==(int) domains.size() && (n==0 || fread(&x[0], sizeof(int), n, f)==(size_t) n);
+    for (int i=0; ok && i<n; i++)
+      ok = x[i]>=0 && x[i]<domains[i];
+    if (ok)
+      assignments.push_back(x);
+  }
+  fclose(f);
+  return ok;
+}
+
+bool write_assignment(const char *filename, const vector<int> &x)
+{
+  FILE *f = fopen(filename, "wb");
+  if (!f)
+    return false;
+  int n = x.size();
+  bool ok = fwrite(&n, sizeof(int), 1, f)==1 && (n==0 || fwrite(&x[0], sizeof(int), n, f)==(size_t) n);
+  return fclose(f)==0 && ok;
+}
@@ -0,0 +1,41 @@
+#ifndef MIPSTART_H
+#define MIPSTART_H
+
+#include <vector>
+#include "factor_graph.h"
+#include "parity.h"
+
+// Warm starts for the parity constrained MIP. Assignments are compared
+// first on the number of zero potentials (and values outside a domain) they
+// hit, then on their objective.
+
+// iterated conditional modes: every variable in turn takes its best value
+// given the others, until a full pass changes nothing
+void icm(const FactorGraph &fg, std::vector<int> &x);
+
+// guess of the unconstrained MAP: the best rounding of a short TRW-S run for
+// pairwise models, the best value of every variable under the maxima of its
+// factors otherwise
+void map_guess(const FactorGraph &fg, int iterations, std::vector<int> &x);
+
+// moves x onto the coset of basis: the free bits of its encoding are kept
+// and the pivot bits solved for, then a free bit is flipped (its pivots
+// following) whenever that improves the assignment. On return bits is on
+// the coset and x is decoded from it. Returns false if x still has a
+// variable outside its domain.
+bool coset_start(const FactorGraph &fg, const CosetBasis &basis,
+                 const std::vector<int> &bit_var, const std::vector<int> &bit_pos,
+                 std::vector<int> &x, std::vector<int> &bits);
+
+// Assignment files hold one or more records, each the number of variables
+// followed by the value of every variable, all as native ints.
+
+// appends the records of filename to assignments; false if the file cannot
+// be read or a record does not fit domains
+bool read_assignments(const char *filename, const std::vector<int> &domains,
+                      std::vector< std::vector<int> > &assignments);
+
+// writes x as the only record of filename; false on an I/O error
+bool write_assignment(const char *filename, const std::vector<int> &x);
+
+#endif
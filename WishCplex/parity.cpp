@@ -0,0 +1,394 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include "parity.h"
+#include "libpeg.h"
+
+using namespace std;
+
+vector <vector <bool> > parseMatrix(const string &matrixStr, int m, int n)
+{
+  vector <vector <bool> > A;
+  if(matrixStr.empty())
+    return A;
+
+  int len = matrixStr.length();
+
+  const char* matrixChars = matrixStr.c_str();
+
+  A.resize(m);
+  for (int i =0;i<m;i++)
+  {
+    A[i].resize(n+1);
+    A[i][n] = rand()%2==0;     
+  }
+  int rowCounter=0;
+  int colCounter=0;	
+  for (int i=0;i<len;i++){
+    switch(matrixChars[i]){
+      case '1':
+        A[rowCounter][colCounter++] = true;
+        break;
+      case '0':
+        A[rowCounter][colCounter++] = false;
+        break;
+      case '_':
+        colCounter=0;
+        rowCounter++;
+        break;
+    }      
+  }
+  return A;
+}
+
+vector <vector <bool> > generate_Toeplitz_matrix(int m, int n)
+{
+	
+	vector <vector <bool> > A;
+	if (m==0)
+		return A;
+		
+	A.resize(m);
+	int i;
+	for (i =0;i<m;i++)
+	{
+	A[i].resize(n+1);
+	}
+	
+	// first column
+	for (i =0;i<m;i++)
+	{
+		if (rand()%2==0)
+			A[i][0] = true;
+		else
+			A[i][0]=false;
+		for (int j =1;j<m-i;j++)
+			if (j<n)
+				A[i+j][j] = A[i][0];
+	}
+	
+		// last column
+	for (i =0;i<m;i++)
+	{
+		if (rand()%2==0)
+			A[i][n] = true;
+		else
+			A[i][n]=false;
+
+	}
+
+
+	
+	// first row
+	for (int j =1;j<n;j++)
+	{
+		if (rand()%2==0)
+			A[0][j] = true;
+		else
+			A[0][j]=false;
+			
+		for (i =1;i<m;i++)
+			if (j+i<n)
+				A[i][j+i] = A[0][j];
+	}
+	
+	// print
+	//cout << "Random matrix3" <<endl;
+	//print_matrix(A);
+	
+	return A;	
+}
+
+// the nonzero entries of the next non-blank line, which must lie in 1..n
+static bool read_entries(istream &in, int n, vector<int> &entries)
+{
+  string line;
+  while (getline(in, line) && line.find_first_not_of(" \t\r") == string::npos)
+    ;
+  if (!in)
+    return false;
+  istringstream tokens(line);
+  entries.clear();
+  long v;
+  while (tokens >> v) {
+    if (v < 0 || v > n)
+      return false;
+    if (v > 0)
+      entries.push_back(v-1);
+  }
+  return tokens.eof();
+}
+
+bool read_sparse_matrix(const char *filename, SparseMatrix &H)
+{
+  ifstream file;
+  istream *in = &cin;
+  if (strcmp(filename, "-")) {
+    file.open(filename);
+    if (!file)
+      return false;
+    in = &file;
+  }
+
+  string first;
+  if (!getline(*in, first))
+    return false;
+  istringstream head(first);
+  vector<long> sizes;
+  long v;
+  while (head >> v)
+    sizes.push_back(v);
+  if (!head.eof() || sizes.empty() || sizes.size() > 3)
+    return false;
+
+  int n = sizes[0], m;
+  if (sizes.size() == 3) {
+    // quasi-cyclic: Nb Mb Z, then Mb rows of Nb shifts, -1 for a zero
+    // block; shift s joins check ib*Z+a to bit jb*Z+(a+s)%Z
+    int z = sizes[2];
+    m = sizes[1];
+    if (n < 0 || m < 0 || z <= 0)
+      return false;
+    H.n = n*z;
+    H.rows.assign(m*z, vector<int>());
+    for (int ib=0; ib<m; ib++)
+      for (int jb=0; jb<n; jb++) {
+        if (!(*in >> v) || v < -1 || v >= z)
+          return false;
+        if (v >= 0)
+          for (int a=0; a<z; a++)
+            H.rows[ib*z+a].push_back(jb*z+(a+v)%z);
+      }
+    return true;
+  }
+  if (sizes.size() == 1) {
+    // compressed rows: M, the row length, then the padded rows
+    int length;
+    if (!(*in >> m >> length) || n < 0 || m < 0 || length < 0)
+      return false;
+    H.n = n;
+    H.rows.assign(m, vector<int>());
+    for (int i=0; i<m; i++)
+      for (int k=0; k<length; k++) {
+        if (!(*in >> v) || v < 0 || v > n)
+          return false;
+        if (v > 0)
+          H.rows[i].push_back(v-1);
+      }
+    // the merges of a nested family, if any. They are replayed as they
+    // are read: each must join two distinct groups, named by their
+    // smallest rows, the smaller first, as pegNestedMerges writes them;
+    // anything else would send pegMergeRows round a cycle of rows
+    int num_merges;
+    H.merges.clear();
+    if (!(*in >> num_merges))
+      return true;
+    if (num_merges != m-1)
+      return false;
+    H.merges.resize(2*num_merges);
+    vector<int> group(m);
+    for (int i=0; i<m; i++)
+      group[i] = i;
+    for (int k=0; k<num_merges; k++) {
+      for (int e=0; e<2; e++) {
+        if (!(*in >> v) || v < 1 || v > m)
+          return false;
+        H.merges[2*k+e] = v-1;
+      }
+      int a = H.merges[2*k], b = H.merges[2*k+1];
+      if (a >= b || group[a] != a || group[b] != b)
+        return false;
+      group[b] = a;
+    }
+    return true;
+  }
+
+  // alist: N M, the largest column and row weights, the N column weights,
+  // the M row weights, then the N columns and the M rows. Zeros are padding.
+  m = sizes[1];
+  int max_col, max_row;
+  if (!(*in >> max_col >> max_row) || n < 0 || m < 0)
+    return false;
+  vector<int> col_weight(n), row_weight(m);
+  for (int j=0; j<n; j++)
+    if (!(*in >> col_weight[j]))
+      return false;
+  for (int i=0; i<m; i++)
+    if (!(*in >> row_weight[i]))
+      return false;
+  string rest;
+  getline(*in, rest);
+  vector<int> entries;
+  for (int j=0; j<n; j++)
+    if (!read_entries(*in, m, entries) || (int) entries.size() != col_weight[j])
+      return false;
+  H.n = n;
+  H.rows.assign(m, vector<int>());
+  for (int i=0; i<m; i++)
+    if (!read_entries(*in, n, H.rows[i]) || (int) H.rows[i].size() != row_weight[i])
+      return false;
+  return true;
+}
+
+bool generate_peg_matrix(const char *spec, int m, int n, unsigned long seed, const char *cacheDir,
+                         int nested_m, SparseMatrix &H)
+{
+  int *deg, *degSeq, *rowStart, *colIndex;
+  double *frac;
+  if (m <= 0 || m > n || (nested_m > 0 && (nested_m < m || nested_m > n)))
+    return false;
+  int numDeg = pegReadDegrees(spec, deg, frac);
+  if (numDeg == 0)
+    return false;
+  degSeq = pegDegreeSequence(n, numDeg, deg, frac);
+  // as MainPEG: best-effort concentrated check degrees, greedy PEG
+  // a nested family keeps its merges in the cache next to the code
+  int M = (nested_m > 0) ? nested_m : m;
+  int *merges = NULL;
+  bool cached = cacheDir != NULL && cacheDir[0];
+  if (cached && M > m)
+    pegGenerateNestedCached(cacheDir, M, n, degSeq, 1, 100000, seed, rowStart, colIndex, merges);
+  else if (cached)
+    pegGenerateCached(cacheDir, M, n, degSeq, 1, 100000, seed, rowStart, colIndex);
+  else
+    pegGenerate(M, n, degSeq, 1, 100000, seed, rowStart, colIndex);
+  H.n = n;
+  H.rows.assign(M, vector<int>());
+  for (int i=0; i<M; i++)
+    H.rows[i].assign(colIndex+rowStart[i], colIndex+rowStart[i+1]);
+  H.merges.clear();
+  if (M > m) {
+    if (merges == NULL) {
+      merges = new int[2*M];
+      pegNestedMerges(M, n, rowStart, colIndex, merges);
+    }
+    H.merges.assign(merges, merges+2*(M-1));
+    select_nested_level(H, m);
+  }
+  delete [] merges;
+  delete [] deg;
+  delete [] frac;
+  delete [] degSeq;
+  delete [] rowStart;
+  delete [] colIndex;
+  return true;
+}
+
+bool select_nested_level(SparseMatrix &H, int m)
+{
+  int M = H.rows.size();
+  if (m == M)
+    return true;
+  if (H.merges.empty() || m <= 0 || m > M)
+    return false;
+  vector<int> rowStart(M+1, 0), colIndex;
+  for (int i=0; i<M; i++) {
+    colIndex.insert(colIndex.end(), H.rows[i].begin(), H.rows[i].end());
+    rowStart[i+1] = colIndex.size();
+  }
+  int *levelRowStart, *levelColIndex;
+  pegMergeRows(M, H.n, &rowStart[0], colIndex.empty() ? NULL : &colIndex[0], &H.merges[0], m,
+               levelRowStart, levelColIndex);
+  H.rows.assign(m, vector<int>());
+  for (int i=0; i<m; i++)
+    H.rows[i].assign(levelColIndex+levelRowStart[i], levelColIndex+levelRowStart[i+1]);
+  H.merges.clear();
+  delete [] levelRowStart;
+  delete [] levelColIndex;
+  return true;
+}
+
+vector< vector<bool> > expand_sparse_matrix(const SparseMatrix &H, bool shuffle)
+{
+  int m = H.rows.size();
+  vector< vector<bool> > A(m, vector<bool>(H.n+1, false));
+  for (int i=0; i<m; i++)
+    A[i][H.n] = rand()%2==0;
+  vector<int> column(H.n);
+  for (int j=0; j<H.n; j++)
+    column[j] = j;
+  if (shuffle)
+    for (int j=H.n-1; j>0; j--)
+      swap(column[j], column[rand()%(j+1)]);
+  for (int i=0; i<m; i++)
+    for (size_t k=0; k<H.rows[i].size(); k++)
+      A[i][column[H.rows[i][k]]] = true;
+  return A;
+}
+
+bool set_offsets(vector< vector<bool> > &A, const string &offsets)
+{
+  size_t i = 0;
+  for (size_t k=0; k<offsets.size(); k++)
+    if (offsets[k] == '0' || offsets[k] == '1') {
+      if (i == A.size())
+        return false;
+      A[i].back() = offsets[k] == '1';
+      i++;
+    }
+  return i == A.size();
+}
+
+void encoding_bits(const vector<int> &domains, vector<int> &bit_var, vector<int> &bit_pos)
+{
+  bit_var.clear();
+  bit_pos.clear();
+  for (size_t i=0; i<domains.size(); i++)
+    for (int k=0; (1<<k)<domains[i]; k++) {
+      bit_var.push_back(i);
+      bit_pos.push_back(k);
+    }
+}
+
+CosetBasis reduce_coset(const vector< vector<bool> > &A)
+{
+  CosetBasis basis;
+  basis.solvable = true;
+  if (A.empty())
+    return basis;
+
+  vector< vector<bool> > rows(A);
+  size_t n = rows[0].size()-1;
+  size_t r = 0;
+  for (size_t col=0; col<n && r<rows.size(); col++) {
+    size_t pivot = r;
+    while (pivot<rows.size() && !rows[pivot][col])
+      pivot++;
+    if (pivot==rows.size())
+      continue;
+    rows[pivot].swap(rows[r]);
+    for (size_t h=0; h<rows.size(); h++)
+      if (h!=r && rows[h][col])
+        for (size_t q=col; q<=n; q++)
+          rows[h][q] = rows[h][q] != rows[r][q];
+    basis.pivots.push_back(col);
+    r++;
+  }
+  // remaining rows are 0 = b
+  for (size_t h=r; h<rows.size(); h++)
+    if (rows[h][n])
+      basis.solvable = false;
+  rows.resize(r);
+  basis.rows.swap(rows);
+  return basis;
+}
+
+int project_to_coset(const CosetBasis &basis, vector<int> &x)
+{
+  int changed = 0;
+  for (size_t r=0; r<basis.rows.size(); r++) {
+    const vector<bool> &row = basis.rows[r];
+    size_t n = row.size()-1;
+    int value = row[n];
+    for (size_t j=basis.pivots[r]+1; j<n; j++)
+      if (row[j])
+        value ^= x[j];
+    if (x[basis.pivots[r]]!=value) {
+      x[basis.pivots[r]] = value;
+      changed++;
+    }
+  }
+  return changed;
+}
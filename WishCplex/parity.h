@@ -0,0 +1,74 @@
+#ifndef PARITY_H
+#define PARITY_H
+
+#include <vector>
+#include <string>
+
+// Parity constraints A x = b over GF(2). Matrices are stored row by row
+// with b in the last column, as everywhere in WH_cplex.
+
+// m x n matrix from rows of 0/1 separated by '_'; b is drawn with rand()
+std::vector< std::vector<bool> > parseMatrix(const std::string &matrixStr, int m, int n);
+
+// random m x n Toeplitz matrix and b, drawn with rand()
+std::vector< std::vector<bool> > generate_Toeplitz_matrix(int m, int n);
+
+// sparse parity check matrix: the 0-based columns of every row
+struct SparseMatrix {
+  int n;
+  std::vector< std::vector<int> > rows;
+  // merge order of a nested family of codes, as pegNestedMerges in
+  // ldpcireg/PEG2/libpeg.h (0-based rows); empty for a single code
+  std::vector<int> merges;
+};
+
+// reads H from filename, or from stdin if it is "-". The format is told by
+// the first line: alist starts with "N M", the compressed rows written by
+// BigGirth::writeToFile_Hcompressed with N alone (then M, the row length and
+// M rows of 1-based columns padded with 0, and for the nested family of
+// MainPEG -nested M-1 and the merges of 1-based rows), the shift exponents written by
+// QCGirth::writeToFile_Hexponent with "Nb Mb Z" (then Mb rows of Nb shifts,
+// expanded to Mb*Z rows as they are read). False if H is malformed.
+bool read_sparse_matrix(const char *filename, SparseMatrix &H);
+
+// PEG code of m checks over n bits, built in memory by libpeg with the given
+// seed; spec is a degree distribution as taken by pegReadDegrees (a MainPEG
+// degree file, or "d1:f1,d2:f2,..."). If cacheDir is not empty the code is
+// looked up in (or added to) that PEG code cache. If nested_m > 0, the code
+// is the level m of the nested family of the code of nested_m checks, so
+// all m share one construction. False if spec is malformed or m > n.
+bool generate_peg_matrix(const char *spec, int m, int n, unsigned long seed, const char *cacheDir,
+                         int nested_m, SparseMatrix &H);
+
+// H becomes the code of m checks of its nested family (unchanged if m is
+// its number of rows); false if H is not nested or has fewer than m rows
+bool select_nested_level(SparseMatrix &H, int m);
+
+// dense form of H with b drawn with rand() as in parseMatrix; if shuffle,
+// the columns are then permuted at random
+std::vector< std::vector<bool> > expand_sparse_matrix(const SparseMatrix &H, bool shuffle);
+
+// replaces b by offsets, one '0' or '1' per row (other characters are
+// skipped); false if their number is not the number of rows
+bool set_offsets(std::vector< std::vector<bool> > &A, const std::string &offsets);
+
+// hashed bits of the binary encoding of WH_cplex: none for a domain of 1,
+// the variable itself for 2, else ceil(log2 d) bits, least significant
+// first. Bit j is bit bit_pos[j] of variable bit_var[j].
+void encoding_bits(const std::vector<int> &domains, std::vector<int> &bit_var, std::vector<int> &bit_pos);
+
+// reduced row echelon form of A x = b: every pivot column appears in the
+// row of its pivot only
+struct CosetBasis {
+  std::vector< std::vector<bool> > rows;
+  std::vector<int> pivots;
+  bool solvable;
+};
+
+CosetBasis reduce_coset(const std::vector< std::vector<bool> > &A);
+
+// keeps the free bits of x and solves for the pivot bits, so that x lies on
+// the coset; returns the number of bits changed
+int project_to_coset(const CosetBasis &basis, std::vector<int> &x);
+
+#endif
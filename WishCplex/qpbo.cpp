@@ -0,0 +1,90 @@
+#include <cmath>
+#include <algorithm>
+#include "maxflow.h"
+#include "qpbo.h"
+
+using namespace std;
+
+// The energy E = -sum of the log10 tables is reparametrized into a constant,
+// unary terms and pairwise terms that are either (1-x_p) x_q (submodular) or
+// (1-x_p)(1-x_q) (not). On the doubled graph with a node p for x_p and a node
+// n+p for its complement both kinds become cut edges, each with half of the
+// weight; a minimum cut gives the roof dual and labels p when p and n+p fall
+// on opposite sides.
+bool qpbo_presolve(const FactorGraph &fg, vector<int> &label, double &upper_bound)
+{
+  int n = fg.nbvar;
+  label.assign(n, -1);
+  for (int v=0; v<n; v++)
+    if (fg.domains[v]!=2)
+      return false;
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    if (fg.scopes[l].size()>2 || (fg.scopes[l].size()==2 && fg.scopes[l][0]==fg.scopes[l][1]))
+      return false;
+    for (size_t t=0; t<fg.tables[l].size(); t++)
+      if (!isfinite(fg.tables[l][t]))
+        return false;
+  }
+
+  MaxFlow graph(2*n);
+  double constant = 0;
+  vector<double> theta0(n, 0), theta1(n, 0);
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    const vector<int> &scope = fg.scopes[l];
+    const vector<double> &table = fg.tables[l];
+    if (scope.empty()) {
+      constant -= table[0];
+      continue;
+    }
+    if (scope.size()==1) {
+      theta0[scope[0]] -= table[0];
+      theta1[scope[0]] -= table[1];
+      continue;
+    }
+    int p = scope[0], q = scope[1];
+    double A = -table[0], B = -table[1], C = -table[2], D = -table[3];
+    if (A+D <= B+C) {
+      // A + (C-A) x_p + (D-C) x_q + (B+C-A-D) (1-x_p) x_q
+      constant += A;
+      theta1[p] += C-A;
+      theta1[q] += D-C;
+      double w = (B+C-A-D)/2;
+      graph.add_edge(p, q, w, 0);
+      graph.add_edge(n+q, n+p, w, 0);
+    }
+    else {
+      // B + (D-B) x_p + (C-D) (1-x_q) + (A+D-B-C) (1-x_p)(1-x_q)
+      constant += B;
+      theta1[p] += D-B;
+      theta0[q] += C-D;
+      double w = (A+D-B-C)/2;
+      graph.add_edge(p, n+q, w, 0);
+      graph.add_edge(q, n+p, w, 0);
+    }
+  }
+
+  // x_p = 1 puts p on the sink side and n+p on the source side
+  for (int p=0; p<n; p++) {
+    double delta = theta1[p] - theta0[p];
+    constant += min(theta0[p], theta1[p]);
+    if (delta > 0) {
+      graph.add_tweights(p, delta/2, 0);
+      graph.add_tweights(n+p, 0, delta/2);
+    }
+    else if (delta < 0) {
+      graph.add_tweights(p, 0, -delta/2);
+      graph.add_tweights(n+p, -delta/2, 0);
+    }
+  }
+
+  double flow = graph.maxflow();
+  upper_bound = -(constant + flow);
+  for (int p=0; p<n; p++) {
+    bool s = graph.in_source_set(p), s_bar = graph.in_source_set(n+p);
+    if (s && !s_bar)
+      label[p] = 0;
+    else if (!s && s_bar)
+      label[p] = 1;
+  }
+  return true;
+}
@@ -0,0 +1,15 @@
+#ifndef QPBO_H
+#define QPBO_H
+
+#include <vector>
+#include "factor_graph.h"
+
+// Roof duality (QPBO) for the MAP of a binary pairwise model. On return
+// label[i] is 0 or 1 for the persistent variables (some MAP assignment takes
+// that value, jointly for all labeled variables) and -1 otherwise;
+// upper_bound is the roof dual bound on the log10 objective. Returns false,
+// labeling nothing, if a variable is not binary, a factor has arity > 2 or a
+// table has zero potentials.
+bool qpbo_presolve(const FactorGraph &fg, std::vector<int> &label, double &upper_bound);
+
+#endif
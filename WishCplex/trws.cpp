@@ -0,0 +1,267 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sys/time.h>
+#include "trws.h"
+
+using namespace std;
+
+static double elapsed_since(const struct timeval &start)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) * 1e-6;
+}
+
+// energies are the negated log10 tables. Zero potentials get a finite
+// penalty: the modified energy is never above the true one, so its dual
+// bound is still valid, and primal values are always taken from fg itself.
+static void add_energy(vector<double> &energy, size_t offset, const vector<double> &table, double penalty)
+{
+  for (size_t t=0; t<table.size(); t++)
+    energy[offset+t] += isfinite(table[t]) ? -table[t] : penalty;
+}
+
+bool is_pairwise(const FactorGraph &fg)
+{
+  for (size_t l=0; l<fg.scopes.size(); l++)
+    if (fg.scopes[l].size()>2)
+      return false;
+  return true;
+}
+
+TRWS::TRWS(const FactorGraph &fg)
+{
+  n = fg.nbvar;
+  dom = fg.domains;
+
+  double range = 1;
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    double lo = 0, hi = 0;
+    bool found = false;
+    for (size_t t=0; t<fg.tables[l].size(); t++)
+      if (isfinite(fg.tables[l][t])) {
+        lo = found ? min(lo, fg.tables[l][t]) : fg.tables[l][t];
+        hi = found ? max(hi, fg.tables[l][t]) : fg.tables[l][t];
+        found = true;
+      }
+    range += hi - lo + fabs(hi);
+  }
+  double penalty = 10*range;
+
+  node_offset.assign(n+1, 0);
+  for (int p=0; p<n; p++)
+    node_offset[p+1] = node_offset[p] + dom[p];
+  unary.assign(node_offset[n], 0);
+  extra.assign(node_offset[n], 0);
+  belief.assign(node_offset[n], 0);
+  constant = 0;
+
+  map< pair<int,int>, int > edge_index;
+  for (size_t l=0; l<fg.scopes.size(); l++)
+    if (fg.scopes[l].size()==2 && fg.scopes[l][0]!=fg.scopes[l][1]) {
+      int a = fg.scopes[l][0], b = fg.scopes[l][1];
+      edge_index[make_pair(min(a, b), max(a, b))] = 0;
+    }
+  int m = edge_index.size();
+  edge_p.resize(m);
+  edge_q.resize(m);
+  pair_offset.assign(m+1, 0);
+  msg_offset.assign(m+1, 0);
+  int e = 0;
+  for (map< pair<int,int>, int >::iterator it=edge_index.begin(); it!=edge_index.end(); ++it, e++) {
+    it->second = e;
+    edge_p[e] = it->first.first;
+    edge_q[e] = it->first.second;
+    pair_offset[e+1] = pair_offset[e] + dom[edge_p[e]]*dom[edge_q[e]];
+    msg_offset[e+1] = msg_offset[e] + dom[edge_p[e]] + dom[edge_q[e]];
+  }
+  pairwise.assign(pair_offset[m], 0);
+  messages.assign(msg_offset[m], 0);
+
+  for (size_t l=0; l<fg.scopes.size(); l++) {
+    const vector<int> &scope = fg.scopes[l];
+    if (scope.empty())
+      constant += isfinite(fg.tables[l][0]) ? -fg.tables[l][0] : penalty;
+    else if (scope.size()==1)
+      add_energy(unary, node_offset[scope[0]], fg.tables[l], penalty);
+    else if (scope[0]==scope[1]) {
+      // a pair over the same variable only has its diagonal
+      vector<double> diagonal(dom[scope[0]]);
+      for (int a=0; a<dom[scope[0]]; a++)
+        diagonal[a] = fg.tables[l][a*dom[scope[0]]+a];
+      add_energy(unary, node_offset[scope[0]], diagonal, penalty);
+    }
+    else {
+      int ei = edge_index[make_pair(min(scope[0], scope[1]), max(scope[0], scope[1]))];
+      if (scope[0] < scope[1])
+        add_energy(pairwise, pair_offset[ei], fg.tables[l], penalty);
+      else {
+        vector<double> transposed(fg.tables[l].size());
+        int d0 = dom[scope[0]], d1 = dom[scope[1]];
+        for (int a=0; a<d0; a++)
+          for (int b=0; b<d1; b++)
+            transposed[b*d0+a] = fg.tables[l][a*d1+b];
+        add_energy(pairwise, pair_offset[ei], transposed, penalty);
+      }
+    }
+  }
+
+  incident.assign(n, vector<Incidence>());
+  for (e=0; e<m; e++) {
+    Incidence at_p = { e, msg_offset[e] + dom[edge_q[e]], msg_offset[e] };
+    Incidence at_q = { e, msg_offset[e], msg_offset[e] + dom[edge_q[e]] };
+    incident[edge_p[e]].push_back(at_p);
+    incident[edge_q[e]].push_back(at_q);
+  }
+  gamma.assign(n, 1);
+  for (int p=0; p<n; p++)
+    if (!incident[p].empty())
+      gamma[p] = 1.0 / incident[p].size();
+}
+
+void TRWS::set_extra_energy(int p, int a, double e)
+{
+  extra[node_offset[p]+a] = e;
+}
+
+// unary energy plus all incoming messages
+void TRWS::compute_belief(int p)
+{
+  double *bp = &belief[node_offset[p]];
+  for (int a=0; a<dom[p]; a++)
+    bp[a] = unary[node_offset[p]+a] + extra[node_offset[p]+a];
+  for (size_t k=0; k<incident[p].size(); k++) {
+    const double *in = &messages[incident[p][k].in];
+    for (int a=0; a<dom[p]; a++)
+      bp[a] += in[a];
+  }
+}
+
+double TRWS::iterate(vector<int> &y)
+{
+  y.resize(n);
+
+  // forward pass with rounding: earlier neighbours are fixed, later ones
+  // contribute their messages
+  for (int p=0; p<n; p++) {
+    compute_belief(p);
+    const double *bp = &belief[node_offset[p]];
+
+    scratch.resize(dom[p]);
+    for (int a=0; a<dom[p]; a++)
+      scratch[a] = unary[node_offset[p]+a] + extra[node_offset[p]+a];
+    for (size_t k=0; k<incident[p].size(); k++) {
+      int ei = incident[p][k].edge;
+      if (edge_q[ei]==p) {
+        int r = edge_p[ei];
+        for (int a=0; a<dom[p]; a++)
+          scratch[a] += pairwise[pair_offset[ei] + y[r]*dom[p] + a];
+      }
+      else {
+        const double *in = &messages[incident[p][k].in];
+        for (int a=0; a<dom[p]; a++)
+          scratch[a] += in[a];
+      }
+    }
+    y[p] = min_element(scratch.begin(), scratch.end()) - scratch.begin();
+
+    for (size_t k=0; k<incident[p].size(); k++) {
+      int ei = incident[p][k].edge;
+      if (edge_p[ei]!=p)
+        continue;
+      int q = edge_q[ei];
+      const double *in = &messages[incident[p][k].in];
+      double *out = &messages[incident[p][k].out];
+      const double *theta = &pairwise[pair_offset[ei]];
+      for (int b=0; b<dom[q]; b++) {
+        double best = INFINITY;
+        for (int a=0; a<dom[p]; a++)
+          best = min(best, gamma[p]*bp[a] - in[a] + theta[a*dom[q]+b]);
+        out[b] = best;
+      }
+      double lowest = *min_element(out, out+dom[q]);
+      for (int b=0; b<dom[q]; b++)
+        out[b] -= lowest;
+    }
+  }
+
+  // backward pass
+  for (int q=n-1; q>=0; q--) {
+    compute_belief(q);
+    const double *bq = &belief[node_offset[q]];
+    for (size_t k=0; k<incident[q].size(); k++) {
+      int ei = incident[q][k].edge;
+      if (edge_q[ei]!=q)
+        continue;
+      int p = edge_p[ei];
+      const double *in = &messages[incident[q][k].in];
+      double *out = &messages[incident[q][k].out];
+      const double *theta = &pairwise[pair_offset[ei]];
+      for (int a=0; a<dom[p]; a++) {
+        double best = INFINITY;
+        for (int b=0; b<dom[q]; b++)
+          best = min(best, gamma[q]*bq[b] - in[b] + theta[a*dom[q]+b]);
+        out[a] = best;
+      }
+      double lowest = *min_element(out, out+dom[p]);
+      for (int a=0; a<dom[p]; a++)
+        out[a] -= lowest;
+    }
+  }
+
+  // dual bound: every edge gets its messages removed and a 1/degree share
+  // of both beliefs; isolated nodes keep their own unary
+  for (int p=0; p<n; p++)
+    compute_belief(p);
+  double bound = constant;
+  for (int p=0; p<n; p++)
+    if (incident[p].empty())
+      bound += *min_element(belief.begin()+node_offset[p], belief.begin()+node_offset[p+1]);
+  for (size_t e=0; e<edge_p.size(); e++) {
+    int p = edge_p[e], q = edge_q[e];
+    const double *to_q = &messages[msg_offset[e]];
+    const double *to_p = &messages[msg_offset[e] + dom[q]];
+    const double *theta = &pairwise[pair_offset[e]];
+    double best = INFINITY;
+    for (int a=0; a<dom[p]; a++)
+      for (int b=0; b<dom[q]; b++)
+        best = min(best, theta[a*dom[q]+b] - to_q[b] - to_p[a]
+                   + gamma[p]*belief[node_offset[p]+a] + gamma[q]*belief[node_offset[q]+b]);
+    bound += best;
+  }
+  return bound;
+}
+
+bool trws_map(const FactorGraph &fg, double timelimit, int max_iterations,
+              vector<int> &x, double &primal, double &upper_bound, int verbosity)
+{
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  if (!is_pairwise(fg))
+    return false;
+
+  TRWS trws(fg);
+  vector<int> y;
+  x.assign(fg.nbvar, 0);
+  primal = -INFINITY;
+  upper_bound = INFINITY;
+  for (int iter=1; iter<=max_iterations; iter++) {
+    upper_bound = min(upper_bound, -trws.iterate(y));
+    double value = evaluate(fg, y);
+    if (value > primal) {
+      primal = value;
+      x = y;
+    }
+
+    if (verbosity >= 2)
+      cout << "TRW-S iteration " << iter << ": primal log10lik = " << primal
+           << ", upper bound log10lik = " << upper_bound << endl;
+    if (isfinite(primal) && upper_bound - primal <= 1e-9 * (1 + fabs(primal)))
+      break;
+    if (timelimit > 0 && elapsed_since(start) >= timelimit)
+      break;
+  }
+  return true;
+}
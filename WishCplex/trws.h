@@ -0,0 +1,62 @@
+#ifndef TRWS_H
+#define TRWS_H
+
+#include <vector>
+#include "factor_graph.h"
+
+// true if every factor has arity <= 2
+bool is_pairwise(const FactorGraph &fg);
+
+// Sequential tree-reweighted message passing (TRW-S, Kolmogorov 2006) on the
+// energy E = -sum of the log10 tables of a pairwise model, every edge being
+// one monotonic chain. Messages persist between iterations, so the energy
+// can be changed through set_extra_energy and the passes warm started.
+class TRWS {
+public:
+  TRWS(const FactorGraph &fg);
+
+  // energy added to value a of variable p on top of the model's own
+  void set_extra_energy(int p, int a, double e);
+
+  // one forward pass, rounding y on the way, and one backward pass; returns
+  // the dual bound: a lower bound on the energy of every assignment
+  double iterate(std::vector<int> &y);
+
+private:
+  struct Incidence {
+    int edge;
+    size_t in;					// message into the node
+    size_t out;					// message out of the node
+  };
+
+  int n;
+  std::vector<int> dom;
+  double constant;
+  std::vector<size_t> node_offset;		// unary blocks, one per node
+  std::vector<double> unary;
+  std::vector<double> extra;
+  // edges sorted by (p,q), p<q, so that the edges leaving a node in the
+  // forward pass are contiguous. Pair tables are row-major in (x_p, x_q);
+  // the messages of edge e are stored next to each other, p->q then q->p.
+  std::vector<int> edge_p, edge_q;
+  std::vector<size_t> pair_offset, msg_offset;
+  std::vector<double> pairwise;
+  std::vector<double> messages;
+  std::vector< std::vector<Incidence> > incident;
+  std::vector<double> gamma;			// 1/degree
+  std::vector<double> belief;
+  std::vector<double> scratch;
+
+  void compute_belief(int p);
+};
+
+// Runs TRW-S on fg. With verbosity 2 or more each iteration prints the best
+// primal value and the dual bound, both as log10 objectives (the levels of
+// WH_cplex -verbosity). Stops after max_iterations, after
+// timelimit seconds (if > 0) or when the gap closes. On return x is the best
+// assignment found, primal its value and upper_bound the best dual bound, an
+// upper bound on the MAP value. Returns false if a factor has arity > 2.
+bool trws_map(const FactorGraph &fg, double timelimit, int max_iterations,
+              std::vector<int> &x, double &primal, double &upper_bound, int verbosity);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef BESTOFPEG
+#define BESTOFPEG
+
+#include <pthread.h>
+#include "BigGirth.h"
+#include "GirthOfGraph.h"
+
+// numCandidates PEG graphs built on a pool of threads, candidate t with the
+// random seed seed+t, of which only the best is kept. Candidates are ranked
+// on their local girth histogram (fewer bit nodes on cycles of length 4,
+// then of length 6, ...), then on the balance of the row weights (the sum
+// of their squares), then on t, so the winner does not depend on the
+// number of threads.
+class BestOfPEG {
+ public:
+  BigGirth *best;
+  GirthOfGraph *bestGirth;
+  int bestCandidate;
+
+  BestOfPEG(int m, int n, int *symbolDegSequence, char *filename, int sglConcent, int tgtGirth,
+            int numCandidates, unsigned long int seed, int numThreads);
+  ~BestOfPEG(void);
+
+ private:
+  int M, N, sglConcent, tgtGirth, numCandidates, nextCandidate;
+  int *symbolDegSequence;
+  char *filename;
+  unsigned long int seed;
+  double bestSquares;
+  pthread_mutex_t lock;
+
+  static void *worker(void *self);
+  int better(GirthOfGraph *girth, double squares, int candidate);
+};
+
+#endif
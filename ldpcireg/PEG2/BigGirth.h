@@ -3,9 +3,11 @@
 
 #include <stdlib.h>
 #include <iostream> // C++ I/O library header
+#include <vector>
 using namespace std;
 #include "Random.h"
 
+// adjacency of a node; the arrays live in the arenas of BigGirth
 class NodesInGraph{
  public:
   int numOfConnectionParityBit;
@@ -13,12 +15,6 @@ class NodesInGraph{
   int numOfConnectionSymbolBit;
   int *connectionSymbolBit;
   int maxDegParity;
-
-  NodesInGraph(void);
-  ~NodesInGraph(void);
-  void setNumOfConnectionSymbolBit(int deg);
-  void initConnectionParityBit(void);
-  void initConnectionParityBit(int deg);
 };
 
 class BigGirth {
@@ -34,20 +30,50 @@ class BigGirth {
   NodesInGraph *nodesInGraph;
   Random *myrandom;
 
-  BigGirth(int m, int n, int *symbolDegSequence, char *filename, int sglConcent, int tgtGirth);
+  BigGirth(int m, int n, int *symbolDegSequence, char *filename, int sglConcent, int tgtGirth,
+           unsigned long int seed=987654321u, int verbose=1);
   BigGirth(void);
 
   void writeToFile_Hcompressed(void);
   void writeToFile_Hmatrix(void);
-  void writeToFile(void);
+  void writeToFile(int numThreads=1);
+  void writeGenerator(const char *genFileName, int numThreads=1);
+  void writeLeftHandGirth(void);
 
   void loadH(void);
+  int exportCSR(int *&rowStart, int *&colIndex);
 
   ~BigGirth(void);
 
  private:
+  // edge arenas: symbolAdj holds the checks of every bit node back to back;
+  // parityAdj holds parityCapacity[i] slots for check i, which move to the
+  // end of the arena when they run out (never under sglConcent==0)
+  int *symbolAdj, *parityAdj, *parityCapacity;
+  int parityAdjSize, parityAdjUsed;
+
+  // scratch of selectParityConnect(): a check c (bit b) is reached in the
+  // current call iff checkStamp[c]==stamp (bitStamp[b]==stamp); reached[]
+  // is the queue of reached checks, in order of depth
+  int *checkStamp, *bitStamp, *reached;
+  int stamp;
+  int numFull; // check nodes at their maximum degree
+
+  // bucket queue of the check nodes below their maximum degree: check c is
+  // bucket[d][bucketPos[c]] with d its degree, bucketPos[c]==-1 once full.
+  // minBucket never decreases, as degrees only grow.
+  vector<int> *bucket;
+  int numBuckets, minBucket;
+  int *bucketPos;
+  int *reachedOfDeg, *degStamp; // reached checks per degree, stamped
+
+  void growConnectionParityBit(int c);
+  void bucketInsert(int c);
+  void bucketRemove(int c);
+  int selectLeastConnected(int levelEnd);
   int selectParityConnect(int kthSymbol, int mthConnection, int & cycle);
   void updateConnection(int kthSymbol);
+  int systematicH(int numThreads, unsigned long int *&rows, int &words, int *J, int *pivotRow);
 
 };
 
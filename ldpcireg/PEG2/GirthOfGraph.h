@@ -0,0 +1,36 @@
+#ifndef GIRTHOFGRAPH
+#define GIRTHOFGRAPH
+
+#include <stdlib.h>
+#include <iostream> // C++ I/O library header
+using namespace std;
+
+// Local girth of every bit node of a Tanner graph given in compressed
+// sparse rows: the bits of check i are colIndex[rowStart[i] .. rowStart[i+1]).
+// The local girth of a bit is the length of the shortest cycle through it,
+// found by a BFS from the bit that stops once no shorter cycle can follow.
+// The BFS are spread over a pool of threads.
+class GirthOfGraph {
+ public:
+  int M, N;
+  int *localGirth; // 0 if the bit is on no cycle (of at most maxGirth)
+
+  GirthOfGraph(int m, int n, int *rowStart, int *colIndex);
+  ~GirthOfGraph(void);
+  void getLocalGirth(int numThreads, int maxGirth);
+  int girth(void);
+  void printGirthTable(void);
+
+ private:
+  // both sides of the graph; nodes are numbered bits first, then checks
+  int *checkStart, *checkIndex; // the checks of bit j are checkIndex[checkStart[j] ..)
+  int *bitStart, *bitIndex;     // the bits of check i are bitIndex[bitStart[i] ..)
+  int maxGirth;
+  int nextBit;                  // first bit not yet handed to a thread
+
+  static void *worker(void *self);
+  int grabBits(int *first);
+  int bfsFromBit(int v, int stamp, int *seen, int *dist, int *branch, int *queue);
+};
+
+#endif
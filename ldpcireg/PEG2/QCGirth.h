@@ -0,0 +1,49 @@
+#ifndef QCGIRTH
+#define QCGIRTH
+
+#include <stdlib.h>
+#include <iostream> // C++ I/O library header
+#include <vector>
+using namespace std;
+#include "Random.h"
+
+// Quasi-cyclic PEG: the Tanner graph is the lifting by Z of a base graph of
+// Mb=M/Z check blocks and Nb=N/Z bit blocks. Every base edge (ib, jb) with
+// shift s stands for the Z x Z circulant permutation joining check ib*Z+a
+// to bit jb*Z+(a+s)%Z. The edges of bit block jb are placed one at a time
+// by the PEG rule, from a BFS of the lifted graph rooted at bit jb*Z: the
+// chosen check gives both the check block and the shift. By symmetry the
+// local girth found holds for all Z bits of the block.
+class QCGirth {
+ public:
+  int M, N, Z, Mb, Nb;
+  int EXPAND_DEPTH;
+  char *filename;
+
+  int *bitDeg;                // number of check blocks of every bit block
+  int **bitBlock, **bitShift; // the check blocks of bit block jb and their shifts
+  int *localGirth;            // of every bit block, as for BigGirth
+
+  QCGirth(int m, int n, int z, int *baseDegSequence, char *filename, int sglConcent, int tgtGirth,
+          unsigned long int seed=987654321u, int verbose=1);
+  ~QCGirth(void);
+
+  void writeToFile_Hexponent(void);
+  int exportCSR(int *&rowStart, int *&colIndex);
+
+ private:
+  // the bit blocks of check block ib and their shifts
+  vector<int> *checkBlockBits, *checkBlockShifts;
+  int *maxDegBlock;           // maximum degree of every check block
+  Random *myrandom;
+
+  // scratch of selectParityConnect() over the lifted graph, as in BigGirth
+  int *checkStamp, *bitStamp, *reached, *blockStamp, *reachedOfBlock;
+  int stamp;
+
+  int selectParityConnect(int jb, int mthConnection, int & cycle);
+  int selectLeastConnected(int jb, int mthConnection, int numReached);
+  void addCirculant(int jb, int m, int c);
+};
+
+#endif
@@ -18,6 +18,10 @@ class Random{
     (*this).seed=987654321u;
     (*this).seed_u=123456789lu;
   }
+  Random(unsigned long int seed) {
+    (*this).seed=seed;
+    (*this).seed_u=123456789lu;
+  }
   ~Random(void){;}
   void bubbleSort(int a[], int size);
   double gauss(double sdev, double mean);
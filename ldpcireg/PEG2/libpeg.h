@@ -0,0 +1,84 @@
+#ifndef LIBPEG
+#define LIBPEG
+
+// PEG codes in memory, for programs that link libpeg.a instead of running
+// MainPEG and reading back its code file.
+
+// reads a degree distribution (node perspective): either the name of a
+// degree file as taken by MainPEG -degFileName, or the distribution itself
+// as "d1:f1,d2:f2,..." or a single degree "d". deg and frac are new[]'d;
+// returns the number of degrees, 0 if spec is malformed or does not sum to 1
+int pegReadDegrees(const char *spec, int *&deg, double *&frac);
+
+// the degrees of N bit nodes in increasing order, as MainPEG assigns them
+int *pegDegreeSequence(int N, int numDeg, const int *deg, const double *frac);
+
+// a PEG Tanner graph of M checks and N bits in compressed sparse rows, as
+// BigGirth::exportCSR: the 0-based bits of check i are colIndex[rowStart[i]
+// .. rowStart[i+1]). Both arrays are new[]'d; returns the number of edges.
+int pegGenerate(int M, int N, const int *degSeq, int sglConcent, int tgtGirth,
+                unsigned long int seed, int *&rowStart, int *&colIndex);
+
+// content-addressed cache of PEG codes in directory cacheDir, one binary
+// file per (M, N, degree sequence, sglConcent, tgtGirth, seed), named
+// peg-MxN-<hash>.csr: a header of 12 unsigned ints (magic, version, M, N,
+// number of edges, sglConcent, tgtGirth, seed and hash as low and high
+// words, number of merges), then degSeq[N], rowStart[M+1], colIndex and
+// the merges of pegNestedMerges (none, or M-1 pairs) as native ints, so
+// the file can be mapped and used in place. The degree sequence is
+// compared on lookup, as the hash alone could collide. pegGenerateCached
+// and pegGenerateNestedCached build a missing entry under an flock() on
+// peg-MxN-<hash>.csr.lock, so concurrent runs build it only once.
+
+// the code cached for these parameters, copied into new[]'d arrays as
+// pegGenerate; returns the number of edges, -1 if it is not cached. If
+// merges is given, *merges is set to a new[]'d copy of the cached merges
+// (2*M ints), or to NULL if the file has none.
+int pegCacheLookup(const char *cacheDir, int M, int N, const int *degSeq, int sglConcent,
+                   int tgtGirth, unsigned long int seed, int *&rowStart, int *&colIndex,
+                   int **merges=NULL);
+
+// stores a code under these parameters (creating cacheDir if needed), with
+// its merges if given; the file is written aside and renamed, so concurrent
+// runs are safe. Returns 0 on failure.
+int pegCacheStore(const char *cacheDir, int M, int N, const int *degSeq, int sglConcent,
+                  int tgtGirth, unsigned long int seed, const int *rowStart, const int *colIndex,
+                  const int *merges=NULL);
+
+// pegGenerate through the cache: looked up, else generated and stored
+int pegGenerateCached(const char *cacheDir, int M, int N, const int *degSeq, int sglConcent,
+                      int tgtGirth, unsigned long int seed, int *&rowStart, int *&colIndex);
+
+// writes a code in the compressed rows of BigGirth::writeToFile_Hcompressed
+void pegWriteCompressed(const char *filename, int M, int N, const int *rowStart, const int *colIndex);
+
+// Nested family of codes from one code of M checks: the code of M' < M
+// checks is the XOR of groups of its rows, after the first M-M' merges of
+// merges[] (2*(M-1) ints; merge k joins the group of row merges[2k+1] to
+// the group of row merges[2k], the smaller rows of the two). Every group
+// of a coarser code is a union of groups of a finer one, so its checks are
+// implied by theirs. The lightest group is merged first, with the group
+// that closes the fewest 4-cycles (shared neighbouring groups) and shares
+// no bit with it if possible, so the column degrees are kept; the lightest
+// such group on ties. This is greedy: the levels are valid codes but their
+// girth is not kept, and it drops well below that of a fresh PEG code of
+// the same shape as M' falls (girth 4 at M/8 from a square code, e.g.).
+void pegNestedMerges(int M, int N, const int *rowStart, const int *colIndex, int *merges);
+
+// pegGenerateCached for a nested family: the code and its merges (new[]'d,
+// 2*M ints) are looked up, else computed and stored, so one construction
+// serves every level of a search
+int pegGenerateNestedCached(const char *cacheDir, int M, int N, const int *degSeq, int sglConcent,
+                            int tgtGirth, unsigned long int seed, int *&rowStart, int *&colIndex,
+                            int *&merges);
+
+// the code of level M' of the family, its rows in the order of their
+// smallest row in the code of M checks; arrays new[]'d as pegGenerate
+int pegMergeRows(int M, int N, const int *rowStart, const int *colIndex, const int *merges,
+                 int levelM, int *&levelRowStart, int *&levelColIndex);
+
+// appends merges[] to a code file, as M-1 and then one line of the two
+// 1-based rows per merge; readers of the compressed rows ignore it
+void pegWriteMerges(const char *filename, int M, const int *merges);
+
+#endif
@@ -1,6 +1,7 @@
 import java.io.IOException;
 import java.io.PrintWriter;
 import java.util.Date;
+import java.util.concurrent.atomic.AtomicLong;
 
 import org.apache.commons.exec.CommandLine;
 import org.apache.commons.exec.DefaultExecutor;
@@ -11,6 +12,11 @@ import org.apache.commons.exec.PumpStreamHandler;
 public class CplexInstance extends Instance{
 	private int mNumVars=0;
 	private double mOptValue=0;
+	private double mUpperBound=Double.NaN;
+	private String mSolutionFile=null;
+	// distinguishes the files of instances created in the same millisecond,
+	// e.g. the components solved in parallel by Hope.fastRunDecomposed
+	private static final AtomicLong sFileCounter = new AtomicLong();
 	public CplexInstance(String path, InstanceParams params) {
 		super(path, params);
 		// TODO Auto-generated constructor stub
@@ -37,12 +43,14 @@ public class CplexInstance extends Instance{
 		return sb.toString();
 	} 
 	
-	public void callCplex(String path, int timeout, int m, boolean[][] matrix, CplexOutput cpo, boolean elim){
+	public void callCplex(String path, int timeout, int m, boolean[][] matrix, String pegSpec, int pegNested, CplexOutput cpo, boolean elim){
 		String matrixStr = convertMatrixToString(matrix);
 		
 		CommandLine cl = new CommandLine(Config.pathToWishCplex);
 		cl.addArgument("-paritylevel");
 		cl.addArgument("1");
+		cl.addArgument("-verbosity");
+		cl.addArgument("0");
 		cl.addArgument("-timelimit");
 		cl.addArgument(""+timeout);
 		cl.addArgument("-number");
@@ -50,9 +58,41 @@ public class CplexInstance extends Instance{
 		if(!elim){
 			cl.addArgument("-skipelim");
 		}
+		if(mParams.useTRWS()){
+			cl.addArgument("-trws");
+		}
+		if(m>0 && mParams.getMipStartFile()!=null){
+			cl.addArgument("-mipstart");
+			cl.addArgument(mParams.getMipStartFile());
+		}
+		if(m>0 && !Double.isNaN(mParams.getUpperCutoff())){
+			cl.addArgument("-upper-cutoff");
+			cl.addArgument(""+mParams.getUpperCutoff()/Math.log(10));
+		}
+		if(stopUntilReached){
+			cl.addArgument("-stop-above");
+			cl.addArgument(""+stopValue/Math.log(10));
+		}
+		if(mSolutionFile!=null){
+			cl.addArgument("-save-solution");
+			cl.addArgument(mSolutionFile);
+		}
 		if(matrixStr!=null){
 			cl.addArgument("-matrix");
 			cl.addArgument(matrixStr);	
+		}else if(pegSpec!=null){
+			// PEG code built by WH_cplex, columns shuffled by -seed as parseDegrees did
+			cl.addArgument("-peg");
+			cl.addArgument(pegSpec);
+			cl.addArgument("-peg-cache");
+			cl.addArgument(Config.output+"pegcache");
+			// with RunParams.setNestedPEG every level is drawn from the nested
+			// family of one cached code, else each level has its own PEG code
+			if(mParams.useNestedPEG() && pegNested>m){
+				cl.addArgument("-peg-nested");
+				cl.addArgument(""+pegNested);
+			}
+			cl.addArgument("-matrix-shuffle");
 		}
 		cl.addArgument(path);
 		
@@ -72,13 +112,18 @@ public class CplexInstance extends Instance{
 	class CplexOutput extends LogOutputStream{
 		private static final String LOG_PREFIX = "Solution value log10lik = ";
 		private static final String VAR_PREFIX = "number of variables = ";
+		private static final String BOUND_PREFIX = "Upper bound log10lik = ";
+		// -verbosity 0: "Result: status log10lik bound elapsed hashed_bits assignment",
+		// elapsed being the wall seconds of the whole WH_cplex run, not only the solve
+		private static final String RESULT_PREFIX = "Result: ";
 		PrintWriter out;
 		
 		private double optimalValue = 0;
 		private int numVars = 0;
+		private double upperBound = Double.NaN;
 		public CplexOutput() throws IOException{
 			long d = new Date().getTime();
-			out = new PrintWriter(Config.output+mParams.isDense() +mReducedDim+d);
+			out = new PrintWriter(Config.output+mParams.isDense() +mReducedDim+d+"_"+sFileCounter.incrementAndGet());
 		}
 		
 		@Override
@@ -91,6 +136,13 @@ public class CplexInstance extends Instance{
 				optimalValue = Double.parseDouble(line.substring(LOG_PREFIX.length()));
 			}else if(line.startsWith(VAR_PREFIX)){
 				numVars = Integer.parseInt(line.substring(VAR_PREFIX.length()));
+			}else if(line.startsWith(BOUND_PREFIX)){
+				upperBound = Double.parseDouble(line.substring(BOUND_PREFIX.length()));
+			}else if(line.startsWith(RESULT_PREFIX)){
+				String[] fields = line.substring(RESULT_PREFIX.length()).trim().split(" ");
+				optimalValue = Double.parseDouble(fields[1]);
+				upperBound = Double.parseDouble(fields[2]);
+				numVars = Integer.parseInt(fields[4]);
 			}
 		}
 				
@@ -101,6 +153,10 @@ public class CplexInstance extends Instance{
 		public int getNumVars(){
 			return this.numVars;
 		}
+		
+		public double getUpperBound(){
+			return this.upperBound;
+		}
 		@Override
 		public void close(){
 			out.close();
@@ -113,11 +169,14 @@ public class CplexInstance extends Instance{
 		int m;
 		boolean elim;
 		boolean[][] matrix=null;
+		String pegSpec=null;
+		int pegNested=0;
 		if(numVars <0 ){
 			//full dimension
 			matrix=null;
 			m=0;
 			elim=true;
+			mSolutionFile=Config.output+"sol"+new Date().getTime()+"_"+sFileCounter.incrementAndGet();
 		}else if(this.mParams.isDense()){
 			matrix=null;
 			m=numVars-this.mReducedDim;
@@ -125,27 +184,21 @@ public class CplexInstance extends Instance{
 		}
 		else if(this.mParams.isRegularPEG()){
 			m=numVars-this.mReducedDim;
-			matrix = LDPCTools.getRPEGMatrix(numVars, m, false);
-			if(matrix==null){
-				elim=true;	
-			}else{
-				elim=false;
-			}
-			BinaryMatrixHelper.printMatrix(matrix);
+			pegSpec = LDPCTools.getRPEGSpec();
+			pegNested = numVars;
+			elim = pegSpec==null;
 		}else{
 			m=numVars-this.mReducedDim;
-			matrix = LDPCTools.getPEGMatrix(numVars, m, false);
-			if(matrix==null){
-				elim=true;	
-			}else{
-				elim=false;
-			}
+			pegSpec = LDPCTools.getPEGSpec();
+			pegNested = numVars;
+			elim = pegSpec==null;
 		}
 		try {
 			CplexOutput cpo = new CplexOutput();
-			callCplex(this.mPath, this.mParams.getTimeLimit(), m, matrix, cpo, elim);
+			callCplex(this.mPath, this.mParams.getTimeLimit(), m, matrix, pegSpec, pegNested, cpo, elim);
 			this.mOptValue = cpo.getOptimalValue()*Math.log(10);
 			this.mNumVars = cpo.getNumVars();
+			this.mUpperBound = cpo.getUpperBound()*Math.log(10);
 		} catch (IOException e) {
 			// TODO Auto-generated catch block
 			e.printStackTrace();
@@ -157,6 +210,14 @@ public class CplexInstance extends Instance{
 		return this.mOptValue;
 	}
 	@Override
+	public double getUpperBound() {
+		return Double.isNaN(this.mUpperBound)?this.mOptValue:this.mUpperBound;
+	}
+	@Override
+	public String getSolutionFile() {
+		return this.mSolutionFile;
+	}
+	@Override
 	public int getOriginalDim() {
 		// TODO Auto-generated method stub
 		return this.mNumVars;
@@ -1,6 +1,19 @@
 import java.io.IOException;
+import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.Date;
+import java.util.List;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+
+import org.apache.commons.exec.CommandLine;
+import org.apache.commons.exec.DefaultExecutor;
+import org.apache.commons.exec.Executor;
+import org.apache.commons.exec.LogOutputStream;
+import org.apache.commons.exec.PumpStreamHandler;
 
 
 public class Hope {
@@ -73,15 +86,15 @@ public class Hope {
   
   private EarlyStopResult earlyStop(Estimate[] estimates){
 	  Estimate current = estimates[0];
-	  double highSum=current.getArea(0);
+	  double highSum=current.getUpperArea(0);
 	  double[] highValues = new double[estimates.length];
-	  highValues[0]=current.getEstimate();	  
+	  highValues[0]=current.getUpperEstimate();	  
 	  for(int i=0;i<estimates.length-1;i++){
 		  if(estimates[i]!=null){
 			  current = estimates[i];
 		  }
-		  highValues[i+1] = current.getEstimate();
-		  highSum += current.getArea(i);
+		  highValues[i+1] = current.getUpperEstimate();
+		  highSum += current.getUpperArea(i);
 	  }
 	  
 	  double lowSum=0;
@@ -156,12 +169,17 @@ public class Hope {
 
   public double fastRun(String path, int sampleSize, RunParams params, RunResult runResult){
 	  	//initial run(unconstrained, full domain)
+		params.setWarmStart(null, Double.NaN);
 		Instance fullInstance = params.getInstance(path); //new LSInstance(path, params);
 		fullInstance.solve(Instance.FULL_DOMAIN);
+		// the unconstrained MAP bounds every parity level and is a good place to start
+		if(fullInstance.getSolutionFile()!=null){
+			params.setWarmStart(fullInstance.getSolutionFile(), fullInstance.getUpperBound());
+		}
 		int fullDim = fullInstance.getOriginalDim();
 		Estimate[] estimates = new Estimate[fullDim+1];
 		double max = fullInstance.getOptimalValue();
-		estimates[0] = new Estimate(max,params.isLogScale());
+		estimates[0] = new Estimate(max,fullInstance.getUpperBound(),params.isLogScale());
 		estimates[fullDim] = estimateQuantile(path, params, fullDim, 0, sampleSize);
 		EarlyStopResult result = null;
 		while(! (result=earlyStop(estimates)).earlyStop() ){
@@ -182,12 +200,91 @@ public class Hope {
 	  	return fastRun(path,sampleSize,params, null);
   }
   
+  /**
+   * Output of WH_cplex -components: the exactly summed part and the files of the
+   * components left to estimate.
+   */
+  class ComponentOutput extends LogOutputStream{
+	  private static final String EXACT_PREFIX = "Exact part log10Z = ";
+	  private static final String FILE_MARKER = ", file = ";
+	  double exactLog10 = 0;
+	  List<String> files = new ArrayList<String>();
+
+	  @Override
+	  protected void processLine(String line, int level) {
+		  if(line==null){
+			  return;
+		  }
+		  if(line.startsWith(EXACT_PREFIX)){
+			  String value = line.substring(EXACT_PREFIX.length());
+			  int end = value.indexOf(' ');
+			  exactLog10 = Double.parseDouble(end>=0?value.substring(0, end):value);
+		  }else if(line.indexOf(FILE_MARKER)>=0){
+			  files.add(line.substring(line.indexOf(FILE_MARKER)+FILE_MARKER.length()).trim());
+		  }
+	  }
+  }
+
+  /**
+   * Estimates the partition function of a model whose graph falls apart into
+   * independent components: log Z is the sum over the components. Small
+   * components are summed out exactly by WH_cplex, the others are estimated
+   * with fastRun in parallel, each with its own copy of params.
+   * @return the estimate of ln Z
+   */
+  public double fastRunDecomposed(String path, final int sampleSize, final RunParams params) throws IOException, InterruptedException{
+	  CommandLine cl = new CommandLine(Config.pathToWishCplex);
+	  cl.addArgument("-components");
+	  cl.addArgument(Config.output+"comp"+new Date().getTime());
+	  cl.addArgument(path);
+	  ComponentOutput out = new ComponentOutput();
+	  Executor exec = new DefaultExecutor();
+	  exec.setStreamHandler(new PumpStreamHandler(out));
+	  exec.setExitValues(null);
+	  exec.execute(cl);
+	  out.close();
+	  System.out.println("components to estimate:"+out.files.size());
+
+	  double logZ = out.exactLog10*Math.log(10);
+	  if(out.files.isEmpty()){
+		  return logZ;
+	  }
+	  int threads = Math.min(out.files.size(), Runtime.getRuntime().availableProcessors());
+	  ExecutorService pool = Executors.newFixedThreadPool(threads);
+	  List<Future<Double>> results = new ArrayList<Future<Double>>();
+	  for(final String file:out.files){
+		  results.add(pool.submit(new Callable<Double>(){
+			  public Double call(){
+				  RunResult r = new RunResult();
+				  fastRun(file, sampleSize, new RunParams(params), r);
+				  return r.estimate;
+			  }
+		  }));
+	  }
+	  try{
+		  for(Future<Double> f:results){
+			  logZ += f.get();
+		  }
+	  }catch(ExecutionException e){
+		  throw new IOException(e.getCause());
+	  }finally{
+		  pool.shutdown();
+	  }
+	  return logZ;
+  }
+
   class Estimate{
 	  double value=0;
+	  // upper bound on the quantile, e.g. a dual bound on the MAP; same as value if unknown
+	  double upperValue=0;
 	  boolean logScale = true;
 	  
 	  public Estimate(double value, boolean logScale){
+		  this(value, value, logScale);
+	  }
+	  public Estimate(double value, double upperValue, boolean logScale){
 		  this.value=value;
+		  this.upperValue=Math.max(value, upperValue);
 		  this.logScale=logScale;
 	  }
 	  public double getEstimate(){
@@ -197,6 +294,16 @@ public class Hope {
 			  return Math.pow(Math.E, this.value);
 		  }
 	  }
+	  public double getUpperEstimate(){
+		  if(!this.logScale){
+			  return this.upperValue;
+		  }else{
+			  return Math.pow(Math.E, this.upperValue);
+		  }
+	  }
+	  public double getUpperArea(int logWidth){
+		  return this.getArea(this.getUpperEstimate(), logWidth);
+	  }
 	  public double getArea(int logWidth){
 		  return this.getArea(this.getEstimate(), logWidth);
 	  }
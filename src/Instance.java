@@ -59,4 +59,18 @@ public abstract class Instance {
 	public abstract double getRuntime();
 	public abstract int getOriginalDim();
 	public abstract String getSolver();
+	
+	/**
+	 * upper bound on the optimum; solvers without a bound return the value found
+	 */
+	public double getUpperBound(){
+		return this.getOptimalValue();
+	}
+	
+	/**
+	 * file with the best assignment, as written by WH_cplex -save-solution; null if none
+	 */
+	public String getSolutionFile(){
+		return null;
+	}
 }
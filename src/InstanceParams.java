@@ -8,6 +8,10 @@ public class InstanceParams{
 	protected ConstraintType constrained = ConstraintType.UNCONSTRAINED;
 	protected double softStrength = 0;
 	protected CodeType code=CodeType.DENSE;
+	protected boolean trws=false;
+	protected boolean nestedPEG=false;
+	protected String mipStartFile=null;
+	protected double upperCutoff=Double.NaN;
 	
 	public InstanceParams(RunParams parent){
 		this.logScale=parent.logScale;
@@ -16,6 +20,10 @@ public class InstanceParams{
 		this.constrained = parent.constrained;
 		this.softStrength = parent.softStrength;
 		this.code=parent.code;
+		this.trws=parent.trws;
+		this.nestedPEG=parent.nestedPEG;
+		this.mipStartFile=parent.mipStartFile;
+		this.upperCutoff=parent.upperCutoff;
 	}
 	
 	public void setSoftConstrainStrength(double str){
@@ -43,6 +51,22 @@ public class InstanceParams{
 		return this.code==CodeType.PEG;
 	}
 	
+	public boolean useTRWS(){
+		return this.trws;
+	}
+	
+	public boolean useNestedPEG(){
+		return this.nestedPEG;
+	}
+	
+	public String getMipStartFile(){
+		return this.mipStartFile;
+	}
+	
+	public double getUpperCutoff(){
+		return this.upperCutoff;
+	}
+	
 	public boolean isLogScale(){
 		return this.logScale;
 	}
@@ -177,6 +177,22 @@ public class LDPCTools {
 		
 	}
 	
+	// degree distribution for WH_cplex -peg, which builds the PEG code
+	// itself; null if the degree file is missing
+	public static String getPEGSpec(){
+		return existing(Config.pathToMPEG+"DenEvl_"+Config.degree+".deg");
+	}
+	
+	public static String getRPEGSpec(){
+		int deg=10;
+		return existing(Config.pathToMPEG+"Reg_"+deg+".deg");
+	}
+	
+	private static String existing(String path){
+		File f = new File(path);
+		return f.exists()?f.getAbsolutePath():null;
+	}
+	
 	private static int[] generateSequentialArray(int n){
 		int[] array = new int[n];
 		for(int i=0;i<array.length;i++){
@@ -185,7 +201,7 @@ public class LDPCTools {
 		return array;
 	}
 	
-	public static String generateDegreeFile(int n, int checks) throws ExecuteException, IOException{
+	public static synchronized String generateDegreeFile(int n, int checks) throws ExecuteException, IOException{
 		String outName = "n"+n+"m"+checks+"d"+Config.degree+".dat";
 		File outf = new File(Config.output+outName);
 		if(outf.exists()){
@@ -221,7 +237,7 @@ public class LDPCTools {
 		out.close();
 	}
 	
-	public static String generateRegularDegreeFile(int n, int checks, int deg) throws ExecuteException, IOException{
+	public static synchronized String generateRegularDegreeFile(int n, int checks, int deg) throws ExecuteException, IOException{
 		String degFile = "Reg_"+deg+".deg";
 		String outName = "n"+n+"m"+checks+"regd"+deg+".dat";
 		File outf = new File(Config.output+outName);
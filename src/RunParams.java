@@ -7,6 +7,10 @@ public class RunParams {
 	protected ConstraintType constrained = ConstraintType.UNCONSTRAINED;
 	protected double softStrength = 0;
 	protected CodeType code=CodeType.DENSE;
+	protected boolean trws=false;
+	protected boolean nestedPEG=false;
+	protected String mipStartFile=null;
+	protected double upperCutoff=Double.NaN;
 
 	private SolverType solver = SolverType.LS;
 	
@@ -54,6 +58,46 @@ public class RunParams {
 		this.code = code;
 		this.solver = solver;
 	}
+	/**
+	 * copy of the parameters, for runs that must not share the state chosen by GO_WITH_THE_BEST
+	 */
+	public RunParams(RunParams other){
+		this.logScale=other.logScale;
+		this.timeLimit=other.timeLimit;
+		this.retry=other.retry;
+		this.constrained=other.constrained;
+		this.softStrength=other.softStrength;
+		this.code=other.code;
+		this.trws=other.trws;
+		this.nestedPEG=other.nestedPEG;
+		this.mipStartFile=other.mipStartFile;
+		this.upperCutoff=other.upperCutoff;
+		this.solver=other.solver;
+		this.bestConstrainedType=other.bestConstrainedType;
+	}
+	/**
+	 * let WH_cplex run TRW-S: it solves the unconstrained MAP and bounds the constrained ones
+	 */
+	public void setTRWS(boolean trws){
+		this.trws=trws;
+	}
+	/**
+	 * draw the PEG codes of every parity level from the nested family of one code
+	 * with a check per hashed bit, instead of a fresh PEG code per level. Saves
+	 * building codes, but the merged levels can have a lower girth than fresh ones,
+	 * most of all at the small levels.
+	 */
+	public void setNestedPEG(boolean nestedPEG){
+		this.nestedPEG=nestedPEG;
+	}
+	/**
+	 * start the parity constrained solves from the assignments in file (null for none)
+	 * and cut off everything above upperCutoff (ln scale, NaN for none)
+	 */
+	public void setWarmStart(String file, double upperCutoff){
+		this.mipStartFile=file;
+		this.upperCutoff=upperCutoff;
+	}
 	public SolverType getSolverType(){
 		return this.solver;
 	}